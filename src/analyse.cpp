@@ -0,0 +1,156 @@
+
+#include <algorithm>
+#include "analyse.h"
+#include "engine.h"
+#include "movegen.h"
+#include "uci.h"
+
+namespace Belette {
+
+class AnalyseEngine : public Engine {
+public:
+    MoveList pv;
+    Score score = SCORE_NONE;
+    int depth = 0;
+    size_t nbNodes = 0;
+
+protected:
+    virtual void onSearchProgress(const SearchEvent &event) { }
+    virtual void onSearchFinish(const SearchEvent &event) {
+        pv = event.pv;
+        score = event.bestScore;
+        depth = event.depth;
+        nbNodes = event.nbNodes;
+    }
+};
+
+struct PositionAnalysis {
+    Score score = SCORE_NONE; // Side to move point of view
+    Move bestMove = MOVE_NONE;
+};
+
+static bool hasLegalMoves(const Position &pos) {
+    bool found = false;
+    enumerateLegalMoves(pos, [&](Move m) { found = true; return false; });
+    return found;
+}
+
+// Mate scores are capped so that the loss of a move stays meaningful
+static inline Score lossScore(Score score) {
+    return std::clamp(score, -2000, 2000);
+}
+
+static inline Score whitePov(Score score, Side stm) {
+    return stm == WHITE ? score : -score;
+}
+
+void analyseGame(const Position &start, const std::vector<Move> &moves, const AnalyseOptions &options) {
+    AnalyseEngine engine;
+    engine.setHashSize(options.hashSize * 1024 * 1024);
+    engine.setKeepMoveHistory(!options.independent);
+
+    SearchLimits limits;
+    limits.maxDepth = options.depth;
+    limits.maxTime = options.moveTime;
+
+    std::vector<PositionAnalysis> results(moves.size() + 1);
+    std::vector<Side> sides(moves.size() + 1);
+    size_t nbNodes = 0;
+    TimeMs startTime = now();
+
+    Position &pos = engine.position();
+    pos = start;
+
+    auto analyse = [&](size_t ply) {
+        PositionAnalysis &result = results[ply];
+        sides[ply] = pos.getSideToMove();
+
+        if (!hasLegalMoves(pos)) {
+            result.score = pos.inCheck() ? -SCORE_MATE : SCORE_DRAW;
+        } else {
+            if (options.independent) engine.newGame();
+
+            engine.search(limits);
+            engine.waitForSearchFinish();
+
+            result.score = engine.score;
+            result.bestMove = engine.pv.empty() ? MOVE_NONE : engine.pv.front();
+            nbNodes += engine.nbNodes;
+        }
+
+        console << "info string analysegame ply " << ply
+                << " depth " << engine.depth
+                << " score " << Uci::formatScore(result.score)
+                << " bestmove " << Uci::formatMove(result.bestMove)
+                << " nodes " << nbNodes << std::endl;
+    };
+
+    if (options.independent) {
+        for (size_t ply = 0; ply <= moves.size(); ply++) {
+            analyse(ply);
+            if (ply < moves.size()) pos.doMove(moves[ply]);
+        }
+    } else {
+        // Walk the game backwards, the positions history is kept for repetition detection
+        for (Move m : moves) pos.doMove(m);
+
+        for (size_t ply = moves.size(); ; ply--) {
+            analyse(ply);
+            if (ply == 0) break;
+            pos.undoMove(moves[ply - 1]);
+        }
+    }
+
+    TimeMs elapsed = std::max<TimeMs>(1, now() - startTime);
+    int nbBlunders[NB_SIDE] = {}, nbMistakes[NB_SIDE] = {};
+    int64_t totalLoss[NB_SIDE] = {};
+    int nbMoves[NB_SIDE] = {};
+
+    console << std::endl;
+
+    for (size_t ply = 0; ply < moves.size(); ply++) {
+        const PositionAnalysis &before = results[ply], &after = results[ply + 1];
+        Side stm = sides[ply];
+
+        // Score of the move played from the point of view of the position before it, one ply further for mates
+        Score played = -after.score;
+        if (std::abs(played) >= SCORE_MATE_MAX_PLY) played -= played > 0 ? 1 : -1;
+
+        Score loss = moves[ply] == before.bestMove ? 0 : std::max(0, lossScore(before.score) - lossScore(played));
+
+        nbMoves[stm]++;
+        totalLoss[stm] += loss;
+
+        int fullMove = start.getFullMoves() + int(ply + (start.getSideToMove() == BLACK)) / 2;
+        console << fullMove << (stm == WHITE ? ". " : "... ") << Uci::formatMove(moves[ply])
+                << " eval " << Uci::formatScore(whitePov(played, stm))
+                << " best " << Uci::formatMove(before.bestMove)
+                << " " << Uci::formatScore(whitePov(before.score, stm))
+                << " loss " << loss;
+
+        if (loss >= options.blunder) {
+            console << " blunder";
+            nbBlunders[stm]++;
+        } else if (loss >= options.blunder / 2) {
+            console << " mistake";
+            nbMistakes[stm]++;
+        }
+
+        console << std::endl;
+    }
+
+    console << std::endl;
+
+    for (Side side : {WHITE, BLACK}) {
+        console << (side == WHITE ? "White" : "Black")
+                << ": blunders " << nbBlunders[side]
+                << " mistakes " << nbMistakes[side]
+                << " average loss " << (nbMoves[side] ? totalLoss[side] / nbMoves[side] : 0) << std::endl;
+    }
+
+    console << "Positions: " << results.size() << std::endl;
+    console << "Nodes: " << nbNodes << std::endl;
+    console << "Time: " << elapsed << "ms" << std::endl;
+}
+
+} /* namespace Belette */
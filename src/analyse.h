@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "position.h"
+#include "utils.h"
+
+namespace Belette {
+
+struct AnalyseOptions {
+    int depth = 0;
+    TimeMs moveTime = 0;
+    int blunder = 200;          // Centipawns lost by the move played to flag it as a blunder, half of it for a mistake
+    size_t hashSize = 16;       // In MB
+    bool independent = false;   // Analyse each position from scratch in the game order, for comparison
+};
+
+// Analyse every position of a game, from the last one to the first one so that the results
+// of the deepest positions are found again in the transposition table by the previous ones
+void analyseGame(const Position &start, const std::vector<Move> &moves, const AnalyseOptions &options);
+
+} /* namespace Belette */
@@ -2,9 +2,20 @@
 #include <chrono>
 #include <thread>
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <memory>
+#include <climits>
+#include <array>
 #include "bench.h"
+#include "dataset.h"
 #include "uci.h"
 #include "utils.h"
+#include "perfcounters.h"
+#include "instrument.h"
+#include "movegen.h"
+#include "movepicker.h"
 
 namespace Belette {
 
@@ -62,44 +73,589 @@ std::vector<std::string> BENCH_POSITIONS = {
     "2r2b2/5p2/5k2/p1r1pP2/P2pB3/1P3P2/K1P3R1/7R w - - 23 93"
 };
 
-class BenchEngine : public UciEngine {
-public:
+constexpr TimeMs TreeWalkBenchTime = 4000; // Total for the two ways of walking the trees
+
+// The built-in positions, or the ones of the file. Empty when the file has none
+static std::vector<std::string> loadBenchPositions(const std::string &file) {
+    if (file.empty()) return BENCH_POSITIONS;
+
+    std::vector<std::string> fens = readFens(file);
+    if (fens.empty()) console << "No valid position found in " << file << std::endl;
+
+    return fens;
+}
+
+struct DepthStats {
+    int depth;
+    TimeMs elapsed;
+    size_t nbNodes;
+};
+
+struct BenchResult {
     size_t nbNodes = 0;
     TimeMs elapsed = 0;
+    Move bestMove = MOVE_NONE;
+    Score score = SCORE_NONE;
+    std::vector<DepthStats> depths;
+    bool perfAvailable[NB_PERF_EVENT] = {};
+    uint64_t perfValues[NB_PERF_EVENT] = {};
+
+    inline size_t nps() const { return 1000ull * nbNodes / std::max<TimeMs>(elapsed, 1); }
+    inline bool hasPerf() const { return std::any_of(std::begin(perfAvailable), std::end(perfAvailable), [](bool b) { return b; }); }
+
+    // Effective branching factor over the last two iterations
+    inline double ebf() const {
+        if (depths.size() < 3) return 0.0;
+        const DepthStats &last = depths.back(), &previous = depths[depths.size() - 3];
+        return std::sqrt(double(last.nbNodes) / std::max<size_t>(previous.nbNodes, 1));
+    }
+};
 
-    size_t nps() { return 1000ull * nbNodes / std::max((uint64_t)elapsed, (uint64_t)1); }
+class BenchEngine : public Engine {
+public:
+    bool perf = false;
+    BenchResult result; // Of the last search
 
 private:
+    PerfCounters counters;
+
+    virtual void onSearchStart() {
+        result = BenchResult();
+
+        // Counters follow the calling thread, so they are opened by the search thread itself
+        if (perf && counters.open()) counters.start();
+    }
     virtual void onSearchProgress(const SearchEvent &event) {
-        //UciEngine::onSearchProgress(event);
+        result.depths.push_back({event.depth, event.elapsed, event.nbNodes});
     }
     virtual void onSearchFinish(const SearchEvent &event) {
-        UciEngine::onSearchFinish(event);
-        nbNodes += event.nbNodes;
-        elapsed += event.elapsed;
+        if (perf) {
+            counters.stop();
+
+            for (int i = 0; i < NB_PERF_EVENT; i++) {
+                result.perfAvailable[i] = counters.available(PerfEvent(i));
+                result.perfValues[i] = counters.value(PerfEvent(i));
+            }
+
+            counters.close();
+        }
+
+        result.nbNodes = event.nbNodes;
+        result.elapsed = event.elapsed;
+        result.bestMove = event.pv.empty() ? MOVE_NONE : event.pv.front();
+        result.score = event.bestScore;
     }
 };
 
+static void printPerf(const bool available[], const uint64_t values[], size_t nbNodes) {
+    if (available[PERF_CYCLES] && available[PERF_INSTRUCTIONS] && values[PERF_CYCLES])
+        console << " ipc " << std::fixed << std::setprecision(2) << double(values[PERF_INSTRUCTIONS]) / values[PERF_CYCLES];
 
-void bench(int depth) {
-    BenchEngine engine;
+    for (int i = 0; i < NB_PERF_EVENT; i++) {
+        if (!available[i]) continue;
+        console << " " << PerfCounters::name(PerfEvent(i)) << "/node " << std::fixed << std::setprecision(2)
+                << double(values[i]) / std::max<size_t>(nbNodes, 1);
+    }
 
-    for (auto fen : BENCH_POSITIONS) {
-        SearchLimits limits;
-        limits.maxDepth = depth;
+    console << std::defaultfloat;
+}
+
+static void printJson(const BenchOptions &options, const std::vector<std::string> &fens, const std::vector<BenchResult> &results, TimeMs wallTime) {
+    size_t nbNodes = 0;
+    TimeMs elapsed = 0;
+
+    for (const BenchResult &result : results) {
+        nbNodes += result.nbNodes;
+        elapsed += result.elapsed;
+    }
+
+    console << "{" << std::endl;
+    console << "  \"engine\": \"Belette " << VERSION << "\"," << std::endl;
+    console << "  \"depth\": " << options.depth << ", \"threads\": " << options.threads << ", \"hash\": " << options.hashSize << "," << std::endl;
+    console << "  \"nodes\": " << nbNodes << ", \"time\": " << elapsed << ", \"wall\": " << wallTime
+            << ", \"nps\": " << 1000ull * nbNodes / std::max<TimeMs>(elapsed, 1) << "," << std::endl;
+    console << "  \"positions\": [" << std::endl;
+
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult &result = results[i];
+
+        console << "    {\"fen\": \"" << fens[i] << "\", \"nodes\": " << result.nbNodes << ", \"time\": " << result.elapsed
+                << ", \"nps\": " << result.nps() << ", \"ebf\": " << std::fixed << std::setprecision(3) << result.ebf() << std::defaultfloat
+                << ", \"bestmove\": \"" << Uci::formatMove(result.bestMove) << "\", \"score\": \"" << Uci::formatScore(result.score) << "\"," << std::endl;
+
+        console << "     \"depths\": [";
+        for (size_t d = 0; d < result.depths.size(); d++) {
+            const DepthStats &depth = result.depths[d];
+            console << (d ? ", " : "") << "{\"depth\": " << depth.depth << ", \"time\": " << depth.elapsed << ", \"nodes\": " << depth.nbNodes << "}";
+        }
+        console << "]";
 
-        console << "position fen " << fen << std::endl;
-        console << "go depth " << depth << std::endl;
+        if (result.hasPerf()) {
+            console << "," << std::endl << "     \"perf\": {";
+            bool first = true;
+            for (int e = 0; e < NB_PERF_EVENT; e++) {
+                if (!result.perfAvailable[e]) continue;
+                console << (first ? "" : ", ") << "\"" << PerfCounters::name(PerfEvent(e)) << "\": " << result.perfValues[e];
+                first = false;
+            }
+            console << "}";
+        }
 
-        engine.newGame();
-        engine.position().setFromFEN(fen);
-        engine.search(limits);
-        engine.waitForSearchFinish();
+        console << "}" << (i + 1 < results.size() ? "," : "") << std::endl;
     }
 
+    console << "  ]" << std::endl;
+    console << "}" << std::endl;
+}
+
+void bench(const BenchOptions &options) {
+    std::vector<std::string> fens = loadBenchPositions(options.file);
+    if (fens.empty()) return;
+
+#ifdef INSTRUMENT
+    resetInstrumentStats();
+#endif
+
+    std::vector<BenchResult> results(fens.size());
+    std::atomic<size_t> nextPosition = 0;
+    std::atomic<bool> perfAvailable = options.perf;
+    std::mutex mutex;
+    TimeMs start = now();
+
+    // Positions are searched from a new game, so the split between engines doesn't change the results
+    auto worker = [&]() {
+        auto engine = std::make_unique<BenchEngine>();
+        engine->setHashSize(options.hashSize * 1024 * 1024);
+
+        size_t i;
+        while ((i = nextPosition++) < fens.size()) {
+            SearchLimits limits;
+            limits.maxDepth = options.depth;
+
+            engine->perf = perfAvailable;
+            engine->newGame();
+            engine->position().setFromFEN(fens[i]);
+            engine->search(limits);
+            engine->waitForSearchFinish();
+
+            const BenchResult &result = results[i] = engine->result;
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if (engine->perf && !result.hasPerf()) {
+                if (!options.json)
+                    console << "info string perf counters unavailable, see /proc/sys/kernel/perf_event_paranoid" << std::endl;
+                perfAvailable = false;
+            }
+
+            if (options.json) continue;
+
+            console << "info string bench position " << (i + 1) << "/" << fens.size()
+                    << " nodes " << result.nbNodes << " time " << result.elapsed << " nps " << result.nps()
+                    << " ebf " << std::fixed << std::setprecision(2) << result.ebf() << std::defaultfloat
+                    << " bestmove " << Uci::formatMove(result.bestMove) << " ttd";
+            for (const DepthStats &depth : result.depths)
+                console << " " << depth.depth << ":" << depth.elapsed;
+            console << std::endl;
+
+            if (result.hasPerf()) {
+                console << "info string perf position " << (i + 1);
+                printPerf(result.perfAvailable, result.perfValues, result.nbNodes);
+                console << std::endl;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < std::max(1, options.threads); t++)
+        threads.emplace_back(worker);
+
+    for (auto &th : threads) th.join();
+
+    TimeMs wallTime = std::max<TimeMs>(now() - start, 1);
+
+    if (options.json) {
+        printJson(options, fens, results, wallTime);
+        return;
+    }
+
+    size_t nbNodes = 0;
+    TimeMs elapsed = 0;
+    bool perfAvailableTotal[NB_PERF_EVENT] = {};
+    uint64_t perfTotals[NB_PERF_EVENT] = {};
+
+    for (const BenchResult &result : results) {
+        nbNodes += result.nbNodes;
+        elapsed += result.elapsed;
+
+        for (int i = 0; i < NB_PERF_EVENT; i++) {
+            perfAvailableTotal[i] |= result.perfAvailable[i];
+            perfTotals[i] += result.perfValues[i];
+        }
+    }
+
+    console << std::endl << "-----------------------------" << std::endl;
+    console << "Positions: " << fens.size() << std::endl;
+    console << "Threads: " << options.threads << std::endl;
+    console << "Hash: " << options.hashSize << std::endl;
+    console << "Elapsed: " << elapsed << std::endl;
+
+    if (options.threads > 1)
+        console << "Wall time: " << wallTime << " (" << 1000ull * nbNodes / wallTime << " nps aggregated)" << std::endl;
+
+    console << nbNodes << " nodes " << 1000ull * nbNodes / std::max<TimeMs>(elapsed, 1) << " nps" << std::endl;
+
+    if (std::any_of(std::begin(perfAvailableTotal), std::end(perfAvailableTotal), [](bool b) { return b; })) {
+        console << std::endl;
+
+        for (int i = 0; i < NB_PERF_EVENT; i++) {
+            if (!perfAvailableTotal[i]) continue;
+            console << std::left << std::setw(14) << PerfCounters::name(PerfEvent(i)) << std::right << std::setw(16) << perfTotals[i] << std::endl;
+        }
+
+        console << "Per node:";
+        printPerf(perfAvailableTotal, perfTotals, nbNodes);
+        console << std::endl;
+    }
+
+#ifdef INSTRUMENT
+    printInstrumentReport(nbNodes);
+#endif
+}
+
+// Time taken by each of the two ways over the same count of leaves or nodes, and the speedup of the second one
+static void printTimings(const char *const names[2], const size_t counts[2], std::array<double, 2> elapsedMs, const char *unit) {
+    for (int k = 0; k < 2; k++) {
+        console << std::left << std::setw(13) << (std::string(names[k]) + ":") << std::right << std::fixed << std::setprecision(0)
+                << std::setw(8) << elapsedMs[k] << " ms " << std::setw(12) << 1000 * counts[k] / std::max(elapsedMs[k], 1.0) << " " << unit << "/s" << std::endl;
+    }
+
+    console << "Speedup: " << std::setprecision(2) << std::max(elapsedMs[0], 1.0) / std::max(elapsedMs[1], 1.0) << std::defaultfloat << std::endl;
+}
+
+// Times two ways of walking the trees of the positions, as size_t walk(Position&, uint64_t& checksum) giving the
+// number of leaves. Both must give the same leaves and checksums, the checksum is left alone when the move orders
+// may legitimately differ
+template<typename WalkA, typename WalkB>
+static void compareTreeWalks(const BenchOptions &options, const char *nameA, const char *nameB, WalkA &&walkA, WalkB &&walkB) {
+    std::vector<std::string> fens = loadBenchPositions(options.file);
+    if (fens.empty()) return;
+
+    std::vector<Position> positions(fens.size());
+    for (size_t i = 0; i < fens.size(); i++)
+        positions[i].setFromFEN(fens[i]);
+
+    const char *names[2] = {nameA, nameB};
+    size_t nbLeaves[2] = {};
+    uint64_t checksum[2] = {};
+    TimeMs elapsed[2] = {};
+    int nbIterations = 0;
+
+    // Alternating the two, so a frequency change doesn't favour one of them. The trees are small, they are walked
+    // again and again until the time is up
+    for (; elapsed[0] + elapsed[1] < TreeWalkBenchTime; nbIterations++) {
+        for (int k = 0; k < 2; k++) {
+            TimeMs start = now();
+
+            for (Position &pos : positions)
+                nbLeaves[k] += k ? walkB(pos, checksum[k]) : walkA(pos, checksum[k]);
+
+            elapsed[k] += now() - start;
+        }
+    }
+
+    if (nbLeaves[0] != nbLeaves[1] || checksum[0] != checksum[1])
+        console << "info string trees differ: " << nbLeaves[0] << " leaves with " << nameA << ", " << nbLeaves[1] << " with " << nameB << std::endl;
+
     console << std::endl << "-----------------------------" << std::endl;
-    console << "Elapsed: " << engine.elapsed << std::endl;
-    console << engine.nbNodes << " nodes " << engine.nps() << " nps" << std::endl;
+    console << "Positions: " << fens.size() << std::endl;
+    console << "Depth: " << options.depth << std::endl;
+    console << "Leaves: " << nbLeaves[0] / std::max(nbIterations, 1) << " x " << nbIterations << " iterations" << std::endl;
+
+    printTimings(names, nbLeaves, {double(elapsed[0]), double(elapsed[1])}, "leaves");
+}
+
+// Number of leaves of the quiescence tree, with the moves picked as qSearch does or generated by victim
+template<Side Me, bool ByVictim>
+static size_t captureTree(Position &pos, int depth) {
+    if (depth <= 0 || pos.inCheck()) return 1;
+
+    size_t nbLeaves = 0;
+    [[maybe_unused]] int lastScore = INT_MAX;
+
+    auto visit = [&](Move move) {
+        if (!pos.see(move, 0)) return true;
+
+        pos.doMove<Me>(move);
+        nbLeaves += captureTree<~Me, ByVictim>(pos, depth - 1);
+        pos.undoMove<Me>(move);
+
+        return true;
+    };
+
+    if constexpr (ByVictim) {
+        enumerateCapturesByVictim<Me>(pos, [&](Move move) {
+#ifndef NDEBUG
+            // Same order as MovePicker::scoreTactical
+            int score = PieceValue<MG>(pos.getPieceAt(moveTo(move))) - (int)pieceType(pos.getPieceAt(moveFrom(move)));
+            assert(score <= lastScore);
+            lastScore = score;
+#endif
+            return visit(move);
+        });
+    } else {
+        MovePicker<QUIESCENCE, Me> mp(pos);
+        mp.enumerate([&](Move move, bool& skipQuiets) { return visit(move); });
+    }
+
+    return std::max<size_t>(nbLeaves, 1);
+}
+
+// A node of the quiescence trees, set up again from its root position and the moves leading to it
+struct CaptureNode {
+    size_t root;
+    std::vector<Move> path;
+};
+
+// The nodes where captureTree generates the captures
+template<Side Me>
+static void collectCaptureNodes(Position &pos, size_t root, std::vector<Move> &path, int depth, std::vector<CaptureNode> &nodes) {
+    if (depth <= 0 || pos.inCheck()) return;
+
+    nodes.push_back({root, path});
+
+    MovePicker<QUIESCENCE, Me> mp(pos);
+    mp.enumerate([&](Move move, bool& skipQuiets) {
+        if (!pos.see(move, 0)) return true;
+
+        path.push_back(move);
+        pos.doMove<Me>(move);
+        collectCaptureNodes<~Me>(pos, root, path, depth - 1, nodes);
+        pos.undoMove<Me>(move);
+        path.pop_back();
+
+        return true;
+    });
+}
+
+// Number of captures of the position, all of them without any SEE filter. Moves of equal MVV-LVA score come in
+// different orders, so they are summed in the checksum rather than folded in order
+template<Side Me, bool ByVictim>
+static size_t generateCaptures(const Position &pos, uint64_t &checksum) {
+    size_t nbMoves = 0;
+
+    auto visit = [&](Move move) {
+        checksum += move;
+        nbMoves++;
+        return true;
+    };
+
+    if constexpr (ByVictim) {
+        enumerateCapturesByVictim<Me>(pos, visit);
+    } else {
+        MovePicker<QUIESCENCE, Me> mp(pos);
+        mp.enumerate([&](Move move, bool& skipQuiets) { return visit(move); });
+    }
+
+    return nbMoves;
+}
+
+template<bool ByVictim>
+static size_t generateCaptures(const Position &pos, uint64_t &checksum) {
+    return pos.getSideToMove() == WHITE ? generateCaptures<WHITE, ByVictim>(pos, checksum) : generateCaptures<BLACK, ByVictim>(pos, checksum);
+}
+
+// Generation alone, the nodes of the quiescence trees are set up by batches outside of the timed part
+static void compareCaptureGeneration(const BenchOptions &options) {
+    constexpr size_t BatchSize = 64;
+
+    std::vector<std::string> fens = loadBenchPositions(options.file);
+    if (fens.empty()) return;
+
+    std::vector<Position> roots(fens.size());
+    std::vector<CaptureNode> nodes;
+    std::vector<Move> path;
+
+    for (size_t i = 0; i < fens.size(); i++) {
+        roots[i].setFromFEN(fens[i]);
+        if (roots[i].getSideToMove() == WHITE) collectCaptureNodes<WHITE>(roots[i], i, path, options.depth, nodes);
+        else collectCaptureNodes<BLACK>(roots[i], i, path, options.depth, nodes);
+    }
+
+    if (nodes.empty()) return;
+
+    const char *names[2] = {"Move picker", "By victim"};
+    std::vector<Position> batch(BatchSize);
+    size_t nbNodes[2] = {}, nbMoves[2] = {};
+    uint64_t checksum[2] = {};
+    TimeNs elapsed[2] = {};
+    int nbIterations = 0;
+    TimeMs start = now();
+
+    for (; now() - start < TreeWalkBenchTime; nbIterations++) {
+        for (size_t begin = 0; begin < nodes.size(); begin += BatchSize) {
+            size_t size = std::min(BatchSize, nodes.size() - begin);
+
+            for (size_t i = 0; i < size; i++) {
+                batch[i] = roots[nodes[begin + i].root];
+                for (Move move : nodes[begin + i].path)
+                    batch[i].doMove(move);
+            }
+
+            // The first one finds the batch just set up in the caches, so they take turns
+            for (int j = 0; j < 2; j++) {
+                int k = j ^ ((begin / BatchSize) & 1);
+                TimeNs batchStart = nowNs();
+
+                for (size_t i = 0; i < size; i++)
+                    nbMoves[k] += k ? generateCaptures<true>(batch[i], checksum[k]) : generateCaptures<false>(batch[i], checksum[k]);
+
+                elapsed[k] += nowNs() - batchStart;
+                nbNodes[k] += size;
+            }
+        }
+    }
+
+    if (nbMoves[0] != nbMoves[1] || checksum[0] != checksum[1])
+        console << "info string captures differ: " << nbMoves[0] << " moves with " << names[0] << ", " << nbMoves[1] << " with " << names[1] << std::endl;
+
+    console << std::endl << "-----------------------------" << std::endl;
+    console << "Capture generation" << std::endl;
+    console << "Positions: " << fens.size() << std::endl;
+    console << "Depth: " << options.depth << std::endl;
+    console << "Nodes: " << nodes.size() << " x " << nbIterations << " iterations, "
+            << std::fixed << std::setprecision(2) << double(nbMoves[0]) / std::max<size_t>(nbNodes[0], 1) << std::defaultfloat << " captures/node" << std::endl;
+
+    printTimings(names, nbNodes, {elapsed[0] / 1e6, elapsed[1] / 1e6}, "nodes");
+}
+
+// The generation alone, then the quiescence walk where the SEE and the moves made take most of the time. Moves of
+// equal MVV-LVA score come in different orders, only the leaves of the walk are compared
+void benchCaptures(const BenchOptions &options) {
+    compareCaptureGeneration(options);
+
+    compareTreeWalks(options, "Move picker", "By victim",
+        [&](Position &pos, uint64_t &) {
+            return pos.getSideToMove() == WHITE ? captureTree<WHITE, false>(pos, options.depth) : captureTree<BLACK, false>(pos, options.depth);
+        },
+        [&](Position &pos, uint64_t &) {
+            return pos.getSideToMove() == WHITE ? captureTree<WHITE, true>(pos, options.depth) : captureTree<BLACK, true>(pos, options.depth);
+        });
+}
+
+// Number of leaves, the order of the moves is folded into the checksum
+template<Side Me, bool BulkScoring>
+static size_t movePickerTree(Position &pos, const MoveHistory &history, int depth, int ply, uint64_t &checksum) {
+    size_t nbLeaves = 0;
+
+    MovePicker<MAIN, Me, BulkScoring> mp(pos, MOVE_NONE, &history, ply);
+    mp.enumerate([&](Move move, bool& skipQuiets) {
+        checksum = checksum * 31 + move;
+
+        if (depth <= 1) {
+            nbLeaves++;
+        } else {
+            pos.doMove<Me>(move);
+            nbLeaves += movePickerTree<~Me, BulkScoring>(pos, history, depth - 1, ply + 1, checksum);
+            pos.undoMove<Me>(move);
+        }
+
+        return true;
+    });
+
+    return nbLeaves;
+}
+
+void benchMovePicker(const BenchOptions &options) {
+    auto history = std::make_unique<MoveHistory>();
+
+    compareTreeWalks(options, "Scalar", "Bulk",
+        [&](Position &pos, uint64_t &checksum) {
+            return pos.getSideToMove() == WHITE ? movePickerTree<WHITE, false>(pos, *history, options.depth, 0, checksum)
+                                                : movePickerTree<BLACK, false>(pos, *history, options.depth, 0, checksum);
+        },
+        [&](Position &pos, uint64_t &checksum) {
+            return pos.getSideToMove() == WHITE ? movePickerTree<WHITE, true>(pos, *history, options.depth, 0, checksum)
+                                                : movePickerTree<BLACK, true>(pos, *history, options.depth, 0, checksum);
+        });
+}
+
+struct ScalingResult {
+    size_t hashSize;
+    int nbInstances;
+    size_t minNps, maxNps, avgNps, aggregatedNps;
+};
+
+void scaling(const ScalingOptions &options) {
+    std::vector<std::string> fens = loadBenchPositions(options.file);
+    if (fens.empty()) return;
+
+    std::vector<ScalingResult> results;
+
+    for (size_t hashSize : options.hashSizes) {
+        for (int nbInstances = 1; nbInstances <= options.maxInstances; nbInstances++) {
+            // Tables are allocated before the clock starts
+            std::vector<std::unique_ptr<BenchEngine>> engines;
+            for (int i = 0; i < nbInstances; i++) {
+                engines.push_back(std::make_unique<BenchEngine>());
+                engines.back()->setHashSize(hashSize * 1024 * 1024);
+            }
+
+            std::vector<size_t> nbNodes(nbInstances, 0);
+            std::vector<TimeMs> elapsed(nbInstances, 0);
+            std::vector<std::thread> threads;
+
+            for (int i = 0; i < nbInstances; i++) {
+                threads.emplace_back([&, i]() {
+                    BenchEngine &engine = *engines[i];
+
+                    for (const std::string &fen : fens) {
+                        SearchLimits limits;
+                        limits.maxDepth = options.depth;
+
+                        engine.newGame();
+                        engine.position().setFromFEN(fen);
+                        engine.search(limits);
+                        engine.waitForSearchFinish();
+
+                        nbNodes[i] += engine.result.nbNodes;
+                        elapsed[i] += engine.result.elapsed;
+                    }
+                });
+            }
+
+            for (auto &th : threads) th.join();
+
+            // Search time only, the hash clearing between positions is left out
+            ScalingResult result = {hashSize, nbInstances, SIZE_MAX, 0, 0, 0};
+
+            for (int i = 0; i < nbInstances; i++) {
+                size_t nps = 1000ull * nbNodes[i] / std::max<TimeMs>(elapsed[i], 1);
+                result.minNps = std::min(result.minNps, nps);
+                result.maxNps = std::max(result.maxNps, nps);
+                result.aggregatedNps += nps;
+            }
+
+            result.avgNps = result.aggregatedNps / nbInstances;
+            results.push_back(result);
+
+            console << "info string scaling hash " << hashSize << " instances " << nbInstances
+                    << " nps " << result.avgNps << " min " << result.minNps << " max " << result.maxNps
+                    << " aggregated " << result.aggregatedNps << std::endl;
+        }
+    }
+
+    // Efficiency compares the aggregated NPS to the single instance one with the same hash size
+    console << std::endl << "    Hash Instances    NPS/instance     Aggregated  Efficiency" << std::endl;
+
+    size_t singleNps = 1;
+    for (const ScalingResult &result : results) {
+        if (result.nbInstances == 1) singleNps = std::max<size_t>(result.avgNps, 1);
+
+        console << std::setw(8) << result.hashSize << std::setw(10) << result.nbInstances
+                << std::setw(16) << result.avgNps << std::setw(15) << result.aggregatedNps
+                << std::setw(11) << std::fixed << std::setprecision(1)
+                << 100.0 * result.aggregatedNps / (double(singleNps) * result.nbInstances) << "%" << std::defaultfloat << std::endl;
+    }
 }
 
-} /* namespace Belette  */
\ No newline at end of file
+} /* namespace Belette  */
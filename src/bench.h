@@ -1,10 +1,44 @@
 #pragma once
 
+#include <string>
+#include <vector>
+
 namespace Belette {
 
 constexpr int DEFAULT_BENCH_DEPTH = 15;
+constexpr int DEFAULT_MOVEPICKER_BENCH_DEPTH = 3;
+
+struct BenchOptions {
+    int depth = DEFAULT_BENCH_DEPTH;
+    int threads = 1;            // Positions are split between this many engines searching concurrently
+    size_t hashSize = 16;       // In MB, for each engine
+    std::string file;           // EPD/FEN positions instead of the built-in ones
+    bool json = false;          // JSON report instead of the text one
+    bool perf = false;          // Hardware counters of each search, when the kernel allows it
+    bool captures = false;      // Quiescence move picking microbenchmark instead of the searches
+    bool movePicker = false;    // Move picker microbenchmark instead of the searches
+};
+
+// The total node count is deterministic for a given depth and positions set, whatever the number of threads
+void bench(const BenchOptions &options);
+
+// Compares the sorting MovePicker with the victim ordered generator, first generating the captures of each node
+// of the quiescence trees of the positions (tacticals with a non negative SEE, out of check, up to the depth), then
+// walking these trees
+void benchCaptures(const BenchOptions &options);
 
-void bench(int depth);
+// Perft of the positions through the move picker, with the quiets scored 8 at a time and one by one
+void benchMovePicker(const BenchOptions &options);
+
+struct ScalingOptions {
+    int depth = 11;
+    int maxInstances = 1;
+    std::vector<size_t> hashSizes = {16}; // In MB
+    std::string file;
+};
+
+// Throughput of 1 to maxInstances independent single threaded engines searching the bench positions side by side,
+// for each hash size. Shows how instances compete for the shared caches and the memory bandwidth
+void scaling(const ScalingOptions &options);
     
 } /* namespace Belette */
-
@@ -47,6 +47,8 @@ extern Bitboard KNIGHT_MOVE[NB_SQUARE];
 extern Bitboard KING_MOVE[NB_SQUARE];
 extern PextEntry BISHOP_MOVE[NB_SQUARE];
 extern PextEntry ROOK_MOVE[NB_SQUARE];
+extern Bitboard ROOK_DATA[0x19000];
+extern Bitboard BISHOP_DATA[0x1480];
 
 extern Bitboard BETWEEN_BB[NB_SQUARE][NB_SQUARE];
 
@@ -0,0 +1,240 @@
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include "book.h"
+#include "pgn.h"
+#include "polyglot.h"
+#include "uci.h"
+#include "utils.h"
+
+namespace Belette {
+
+struct BookRecord {
+    uint64_t key;
+    uint16_t move;
+    uint16_t score; // 2 for a win, 1 for a draw
+};
+
+struct BookKey {
+    uint64_t key;
+    uint16_t move;
+
+    inline bool operator==(const BookKey &other) const { return key == other.key && move == other.move; }
+};
+
+struct BookKeyHash {
+    inline size_t operator()(const BookKey &k) const { return k.key ^ (k.move * 0x9E3779B97F4A7C15ull); }
+};
+
+struct BookCounts {
+    uint64_t weight = 0;
+    uint64_t games = 0;
+};
+
+// (position, move) => counts, split in shards so that workers rarely wait for each other
+class BookMap {
+public:
+    void insert(std::vector<BookRecord> &records) {
+        std::sort(records.begin(), records.end(), [](const BookRecord &a, const BookRecord &b) {
+            return shardIndex(a.key) < shardIndex(b.key);
+        });
+
+        for (auto it = records.begin(); it != records.end(); ) {
+            Shard &shard = shards[shardIndex(it->key)];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+
+            do {
+                BookCounts &counts = shard.map[{it->key, it->move}];
+                counts.weight += it->score;
+                counts.games++;
+            } while (++it != records.end() && &shards[shardIndex(it->key)] == &shard);
+        }
+    }
+
+    size_t size() const {
+        size_t n = 0;
+        for (const Shard &shard : shards) n += shard.map.size();
+        return n;
+    }
+
+    std::vector<std::pair<BookKey, BookCounts>> entries(uint64_t minWeight) const {
+        std::vector<std::pair<BookKey, BookCounts>> entries;
+
+        for (const Shard &shard : shards) {
+            for (const auto &entry : shard.map) {
+                if (entry.second.weight >= minWeight) entries.push_back(entry);
+            }
+        }
+
+        return entries;
+    }
+
+private:
+    static constexpr int NbShards = 64;
+
+    static inline int shardIndex(uint64_t key) { return int(key >> 58); }
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<BookKey, BookCounts, BookKeyHash> map;
+    };
+
+    Shard shards[NbShards];
+};
+
+struct MakeBookStats {
+    size_t games = 0;
+    size_t skipped = 0; // Unknown result or invalid FEN
+    size_t illegal = 0; // Games cut on an unparsable move
+
+    inline MakeBookStats& operator+=(const MakeBookStats &other) {
+        games += other.games;
+        skipped += other.skipped;
+        illegal += other.illegal;
+        return *this;
+    }
+};
+
+static void processChunk(const std::string &chunk, const MakeBookOptions &options, BookMap &book, MakeBookStats &stats) {
+    Position pos;
+    PgnGame game;
+    std::vector<BookRecord> records;
+    size_t offset = 0;
+
+    while (parsePgnGame(chunk, offset, game)) {
+        if (game.result == RESULT_UNKNOWN || !pos.setFromFEN(game.fen.empty() ? STARTPOS_FEN : game.fen)) {
+            stats.skipped++;
+            continue;
+        }
+
+        stats.games++;
+
+        int nbMoves = std::min<int>(options.maxPly, game.moves.size());
+        for (int ply = 0; ply < nbMoves; ply++) {
+            Move m = parseSan(pos, game.moves[ply]);
+
+            if (m == MOVE_NONE) {
+                stats.illegal++;
+                break;
+            }
+
+            float result = pos.getSideToMove() == WHITE ? game.result : 1.0f - game.result;
+            records.push_back({Polyglot::hash(pos), Polyglot::encodeMove(m), uint16_t(2 * result)});
+
+            pos.doMove(m);
+        }
+    }
+
+    book.insert(records);
+}
+
+static bool writeBook(const BookMap &book, const std::string &output, const MakeBookOptions &options, size_t &nbEntries) {
+    auto entries = book.entries(std::max(0, options.minWeight));
+
+    std::sort(entries.begin(), entries.end(), [](const auto &a, const auto &b) {
+        if (a.first.key != b.first.key) return a.first.key < b.first.key;
+        if (a.second.weight != b.second.weight) return a.second.weight > b.second.weight;
+        return a.first.move < b.first.move;
+    });
+
+    std::string buffer(entries.size() * Polyglot::EntrySize, '\0');
+    char *out = buffer.data();
+
+    for (size_t i = 0; i < entries.size(); ) {
+        // Weights are 16 bits, scale down all the moves of a position when needed, the moves that only lost
+        // keep their weight of 0. Entries are sorted by decreasing weight for a given key so the first one is the maximum
+        uint64_t maxWeight = entries[i].second.weight;
+        uint64_t key = entries[i].first.key;
+
+        for (; i < entries.size() && entries[i].first.key == key; i++) {
+            const auto &[bookKey, counts] = entries[i];
+            uint64_t weight = maxWeight > 0xFFFF && counts.weight > 0 ? std::max<uint64_t>(1, counts.weight * 0xFFFF / maxWeight) : counts.weight;
+
+            Polyglot::writeEntry(out, {key, bookKey.move, uint16_t(weight), uint32_t(std::min<uint64_t>(counts.games, UINT32_MAX))});
+            out += Polyglot::EntrySize;
+        }
+    }
+
+    std::ofstream file(output, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+
+    file.write(buffer.data(), buffer.size());
+    nbEntries = entries.size();
+
+    return !!file;
+}
+
+void makebook(const std::vector<std::string> &pgns, const std::string &output, const MakeBookOptions &options) {
+    constexpr size_t ChunkSize = 4 << 20; // Per thread
+
+    MakeBookOptions opts = options;
+    opts.maxPly = std::clamp(opts.maxPly, 1, MAX_HISTORY - 1);
+    int nbThreads = std::max(1, opts.threads);
+
+    PgnReader reader;
+    size_t nextFile = 0;
+    bool opened = false;
+
+    // Chunks are filled from the files in order, one per thread
+    auto readChunks = [&](std::vector<std::string> &chunks) {
+        chunks.resize(nbThreads);
+
+        for (auto &chunk : chunks) {
+            chunk.clear();
+
+            while (!(opened && reader.nextChunk(chunk, ChunkSize)) && nextFile < pgns.size()) {
+                opened = reader.open(pgns[nextFile]);
+                if (!opened) console << "Unable to open PGN file " << pgns[nextFile] << std::endl;
+                nextFile++;
+            }
+        }
+
+        while (!chunks.empty() && chunks.back().empty()) chunks.pop_back();
+    };
+
+    BookMap book;
+    std::vector<std::string> current, next;
+    std::vector<MakeBookStats> stats(nbThreads);
+    MakeBookStats total;
+    TimeMs start = now();
+
+    readChunks(current);
+
+    // Workers parse the current chunks while the next ones are read
+    while (!current.empty()) {
+        std::vector<std::thread> threads;
+
+        for (size_t t = 0; t < current.size(); t++) {
+            stats[t] = MakeBookStats();
+            threads.emplace_back([&, t] { processChunk(current[t], opts, book, stats[t]); });
+        }
+
+        readChunks(next);
+
+        for (auto &th : threads) th.join();
+        for (size_t t = 0; t < current.size(); t++) total += stats[t];
+
+        std::swap(current, next);
+
+        TimeMs elapsed = std::max<TimeMs>(1, now() - start);
+        console << "info string makebook games " << total.games << " gps " << (1000 * total.games / elapsed) << std::endl;
+    }
+
+    size_t nbEntries = 0;
+    if (!writeBook(book, output, opts, nbEntries)) {
+        console << "Unable to write book " << output << std::endl;
+        return;
+    }
+
+    TimeMs elapsed = std::max<TimeMs>(1, now() - start);
+    console << "Games: " << total.games << std::endl;
+    console << "Skipped (no result or invalid FEN): " << total.skipped << std::endl;
+    console << "Cut on illegal move: " << total.illegal << std::endl;
+    console << "Positions/moves: " << book.size() << std::endl;
+    console << "Book entries: " << nbEntries << std::endl;
+    console << "Time: " << elapsed << "ms (" << (1000 * total.games / elapsed) << " games/s)" << std::endl;
+}
+
+} /* namespace Belette */
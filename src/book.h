@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace Belette {
+
+struct MakeBookOptions {
+    int maxPly = 30;    // Only the first plies of each game are recorded
+    int minWeight = 1;  // Entries whose weight is below are dropped, 0 keeps the moves that only lost
+    int threads = 1;
+};
+
+// Build a Polyglot book from PGN files. The weight of a move is 2 * wins + draws for the side playing it,
+// the learn field holds the number of games it was played in
+void makebook(const std::vector<std::string> &pgns, const std::string &output, const MakeBookOptions &options);
+
+} /* namespace Belette */
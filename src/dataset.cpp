@@ -0,0 +1,246 @@
+
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include "dataset.h"
+#include "uci.h"
+
+namespace Belette {
+
+PackedEntry pack(const Position &pos, float result, Score score) {
+    PackedEntry packed;
+    std::memset(&packed, 0, sizeof(PackedEntry));
+
+    assert(pos.nbPieces() <= 32);
+
+    Bitboard occupied = packed.occupancy = pos.getPiecesBB();
+    int i = 0;
+    bitscan_loop(occupied) {
+        Square sq = bitscan(occupied);
+        packed.pieces[i / 2] |= uint8_t(pos.getPieceAt(sq)) << (4 * (i & 1));
+        i++;
+    }
+
+    packed.flags = uint8_t(pos.getCastlingRights()) | (pos.getSideToMove() << 7);
+    packed.epSquare = uint8_t(pos.getEpSquare());
+    packed.fiftyMoveRule = uint8_t(std::min(pos.getFiftyMoveRule(), 255));
+    packed.result = uint8_t(std::lround(result * 2));
+    packed.score = int16_t(score);
+    packed.fullMoves = uint16_t(pos.getFullMoves());
+
+    return packed;
+}
+
+bool unpack(const PackedEntry &packed, Position &pos, DataEntry &entry) {
+    std::ostringstream ss;
+    Piece board[NB_SQUARE] = {};
+
+    Bitboard occupied = packed.occupancy;
+    int i = 0;
+    bitscan_loop(occupied) {
+        Square sq = bitscan(occupied);
+        board[sq] = Piece((packed.pieces[i / 2] >> (4 * (i & 1))) & 0xF);
+        i++;
+    }
+
+    for (int r = RANK_8; r >= RANK_1; --r) {
+        int nbEmpty = 0;
+
+        for (int f = FILE_A; f <= FILE_H; ++f) {
+            Piece p = board[square(File(f), Rank(r))];
+
+            if (p == NO_PIECE) {
+                nbEmpty++;
+                continue;
+            }
+
+            if (nbEmpty) ss << nbEmpty;
+            nbEmpty = 0;
+            ss << " PNBRQK  pnbrqk"[p];
+        }
+
+        if (nbEmpty) ss << nbEmpty;
+        if (r > RANK_1) ss << '/';
+    }
+
+    CastlingRight cr = CastlingRight(packed.flags & ANY_CASTLING);
+    ss << ((packed.flags >> 7) ? " b " : " w ");
+    if (cr & WHITE_KING_SIDE) ss << 'K';
+    if (cr & WHITE_QUEEN_SIDE) ss << 'Q';
+    if (cr & BLACK_KING_SIDE) ss << 'k';
+    if (cr & BLACK_QUEEN_SIDE) ss << 'q';
+    if (!cr) ss << '-';
+
+    ss << " " << (packed.epSquare < NB_SQUARE ? Uci::formatSquare(Square(packed.epSquare)) : "-");
+    ss << " " << int(packed.fiftyMoveRule) << " " << int(packed.fullMoves);
+
+    entry.fen = ss.str();
+    entry.result = packed.result / 2.0f;
+    entry.score = packed.score;
+
+    return pos.setFromFEN(entry.fen);
+}
+
+bool parseEpdEntry(const std::string &line, DataEntry &entry) {
+    std::string str = line;
+    std::replace(str.begin(), str.end(), '|', ' ');
+    std::replace(str.begin(), str.end(), ';', ' ');
+
+    std::istringstream parser(str);
+    std::string token;
+    int nbFields = 0;
+
+    entry.fen.clear();
+    entry.score = SCORE_NONE;
+
+    // Pieces, side to move, castling & en passant are mandatory, move counters are optional
+    while (nbFields < 6 && parser >> token) {
+        bool isCounter = !token.empty() && std::all_of(token.begin(), token.end(), ::isdigit);
+        if (nbFields >= 4 && !isCounter) break;
+
+        entry.fen += (nbFields ? " " : "") + token;
+        nbFields++;
+        token.clear();
+    }
+
+    if (nbFields < 4) return false;
+
+    bool hasResult = false;
+
+    do {
+        if (token.empty()) continue;
+
+        bool bracketed = token.front() == '[' || token.front() == '"';
+        token.erase(std::remove_if(token.begin(), token.end(), [](char c) { return c == '[' || c == ']' || c == '"'; }), token.end());
+
+        if (token == "1-0") {
+            entry.result = 1.0f; hasResult = true;
+        } else if (token == "0-1") {
+            entry.result = 0.0f; hasResult = true;
+        } else if (token == "1/2-1/2") {
+            entry.result = 0.5f; hasResult = true;
+        } else if (!token.empty() && (std::isdigit(token[0]) || token[0] == '-')) {
+            if (bracketed || token.find('.') != std::string::npos) {
+                entry.result = std::strtof(token.c_str(), nullptr); hasResult = true;
+            } else {
+                entry.score = parseInt(token);
+            }
+        }
+        // Anything else is an EPD opcode (c9, id, ...)
+    } while (parser >> token);
+
+    return hasResult && entry.result >= 0.0f && entry.result <= 1.0f;
+}
+
+std::string formatEpdEntry(const DataEntry &entry) {
+    std::ostringstream ss;
+    ss << entry.fen << " [" << std::fixed << std::setprecision(1) << entry.result << "]";
+
+    if (entry.score != SCORE_NONE)
+        ss << " " << entry.score;
+
+    return ss.str();
+}
+
+void encodeEntry(std::string &buffer, const Position &pos, const DataEntry &entry, bool binary) {
+    if (binary) {
+        PackedEntry packed = pack(pos, entry.result, entry.score);
+        buffer.append(reinterpret_cast<const char *>(&packed), sizeof(PackedEntry));
+    } else {
+        DataEntry out = entry;
+        out.fen = pos.fen();
+        buffer += formatEpdEntry(out);
+        buffer += '\n';
+    }
+}
+
+bool DatasetReader::open(const std::string &filename) {
+    file.open(filename, std::ios::binary);
+    if (!file) return false;
+
+    char magic[sizeof(DATASET_MAGIC)] = {};
+    file.read(magic, sizeof(magic));
+    binary = file.gcount() == sizeof(magic) && std::memcmp(magic, DATASET_MAGIC, sizeof(magic)) == 0;
+
+    if (!binary) {
+        file.clear();
+        file.seekg(0);
+    }
+
+    line = 0;
+
+    return true;
+}
+
+bool DatasetReader::next(DataEntry &entry) {
+    if (binary) {
+        PackedEntry packed;
+
+        while (file.read(reinterpret_cast<char *>(&packed), sizeof(PackedEntry))) {
+            line++;
+            if (unpack(packed, position, entry)) return true;
+        }
+
+        return false;
+    }
+
+    std::string str;
+
+    while (std::getline(file, str)) {
+        line++;
+        if (parseEpdEntry(str, entry)) return true;
+    }
+
+    return false;
+}
+
+bool DatasetWriter::open(const std::string &filename, bool binary_) {
+    binary = binary_;
+    count = 0;
+    file.open(filename, binary ? std::ios::binary | std::ios::trunc : std::ios::trunc);
+    if (!file) return false;
+
+    if (binary) file.write(DATASET_MAGIC, sizeof(DATASET_MAGIC));
+
+    return true;
+}
+
+void DatasetWriter::write(const Position &pos, const DataEntry &entry) {
+    std::string buffer;
+    encodeEntry(buffer, pos, entry, binary);
+    write(buffer, 1);
+}
+
+void DatasetWriter::write(const std::string &encoded, size_t nbEntries) {
+    file.write(encoded.data(), encoded.size());
+    count += nbEntries;
+}
+
+std::vector<std::string> readFens(const std::string &filename) {
+    std::vector<std::string> fens;
+    std::ifstream file(filename);
+    std::string line, token;
+    auto pos = std::make_unique<Position>();
+
+    while (std::getline(file, line)) {
+        std::istringstream parser(line);
+        std::string fen;
+        int nbFields = 0;
+
+        // Pieces, side to move, castling & en passant, then move counters if any
+        while (nbFields < 6 && parser >> token) {
+            if (nbFields >= 4 && !std::all_of(token.begin(), token.end(), ::isdigit)) break;
+            fen += (nbFields ? " " : "") + token;
+            nbFields++;
+        }
+
+        if (nbFields == 4) fen += " 0 1";
+        if (nbFields >= 4 && pos->setFromFEN(fen)) fens.push_back(pos->fen());
+    }
+
+    return fens;
+}
+
+} /* namespace Belette */
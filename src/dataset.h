@@ -0,0 +1,85 @@
+#pragma once
+
+#include <string>
+#include <fstream>
+#include <vector>
+#include "chess.h"
+#include "position.h"
+
+namespace Belette {
+
+// Labelled position used for tuning, either from an EPD text file or from the binary format
+struct DataEntry {
+    std::string fen;
+    float result;           // Game result from white point of view: 1.0 win, 0.5 draw, 0.0 loss
+    Score score = SCORE_NONE; // Optional search score from white point of view
+};
+
+// Binary format: 32 bytes per position, file starts with DATASET_MAGIC
+struct PackedEntry {
+    uint64_t occupancy;
+    uint8_t pieces[16];     // 4 bits per piece (Piece enum), in occupancy order
+    uint8_t flags;          // bit 0-3: castling rights, bit 7: side to move
+    uint8_t epSquare;       // SQ_NONE if none
+    uint8_t fiftyMoveRule;
+    uint8_t result;         // 0: black win, 1: draw, 2: white win
+    int16_t score;
+    uint16_t fullMoves;
+};
+
+static_assert(sizeof(PackedEntry) == 32);
+
+constexpr char DATASET_MAGIC[8] = {'B', 'L', 'T', 'D', 'A', 'T', 'A', '1'};
+
+PackedEntry pack(const Position &pos, float result, Score score = SCORE_NONE);
+bool unpack(const PackedEntry &packed, Position &pos, DataEntry &entry);
+
+// Parse an EPD line. Supported labels: "[1.0]", "\"1-0\"", "1-0", "| score | 1.0"
+bool parseEpdEntry(const std::string &line, DataEntry &entry);
+std::string formatEpdEntry(const DataEntry &entry);
+
+// Positions of an EPD or FEN file, one per line. Labels and opcodes are ignored, missing move counters are set to "0 1"
+std::vector<std::string> readFens(const std::string &filename);
+
+// Serialize an entry (board from pos, labels from entry) at the end of buffer
+void encodeEntry(std::string &buffer, const Position &pos, const DataEntry &entry, bool binary);
+
+// Streaming reader for both formats (binary files are detected with DATASET_MAGIC)
+class DatasetReader {
+public:
+    DatasetReader() = default;
+    DatasetReader(const DatasetReader &) = delete;
+    DatasetReader &operator=(const DatasetReader &) = delete;
+
+    bool open(const std::string &filename);
+    bool next(DataEntry &entry);
+    inline bool isBinary() const { return binary; }
+    inline size_t lineNumber() const { return line; }
+
+private:
+    std::ifstream file;
+    bool binary = false;
+    size_t line = 0;
+    Position position; // Only used to unpack binary entries
+};
+
+// Writes positions with their labels, either as EPD lines or in the binary format
+class DatasetWriter {
+public:
+    DatasetWriter() = default;
+    DatasetWriter(const DatasetWriter &) = delete;
+    DatasetWriter &operator=(const DatasetWriter &) = delete;
+
+    bool open(const std::string &filename, bool binary);
+    void write(const Position &pos, const DataEntry &entry);
+    void write(const std::string &encoded, size_t nbEntries); // Entries serialized with encodeEntry()
+    inline bool isBinary() const { return binary; }
+    inline size_t size() const { return count; }
+
+private:
+    std::ofstream file;
+    bool binary = false;
+    size_t count = 0;
+};
+
+} /* namespace Belette */
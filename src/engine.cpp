@@ -5,19 +5,42 @@
 #include "movegen.h"
 #include "evaluate.h"
 #include "movepicker.h"
+#include "params.h"
 
 namespace Belette {
 
 int Engine::LMRTable[MAX_PLY][MAX_MOVE];
 
+// CPU contention
+constexpr double ContentionThreshold = 0.1; // Below, the wall clock is trusted
+constexpr int ContentionMaxScale = 3;       // Allocated time can be extended up to this factor,
+constexpr int ContentionMaxTimeDiv = 4;     // and this fraction of the remaining time
+
+// Time manager fast paths
+constexpr int MateConfirmIterations = 3; // Iterations in a row returning the same mate score
+constexpr int OnlyMoveMinDepth = 8;      // Below, proven losses may come from pruned defences
+
+constexpr int MateFallbackDepth = 10; // Regular search after a failed "go mate" without any other limit
+
 void Engine::init() {
     for (int d=1; d<MAX_PLY; d++) {
         for (int m=1; m<MAX_PLY; m++) {
-            LMRTable[d][m] = int(0.25 + 0.46 * std::log(d) * std::log(m));
+            LMRTable[d][m] = int(LmrBase / 100.0 + LmrScale / 100.0 * std::log(d) * std::log(m));
         }
     }
 }
 
+// Trace of the nodes for the tree recorder, plain returns otherwise
+#ifdef INSTRUMENT
+#define TREE_NODE(kind) TreeNodeScope treeNode(treeRecorder.get(), sd->position.previousMove(), ply, depth, alpha, beta, kind)
+#define TREE_TT_HIT(hit) treeNode.setTTHit(hit)
+#define TREE_RETURN(score, reason) return treeNode.result(score, reason)
+#else
+#define TREE_NODE(kind)
+#define TREE_TT_HIT(hit)
+#define TREE_RETURN(score, reason) return score
+#endif
+
 void updatePv(MoveList &pv, Move move, const MoveList &childPv) {
     pv.clear();
     pv.push_back(move);
@@ -29,6 +52,24 @@ void SearchData::initAllocatedTime() {
     Side stm = position.getSideToMove();
 
     allocatedTime = limits.timeLeft[stm] / moves + limits.increment[stm];
+    maximumTime = std::max(allocatedTime, std::min(allocatedTime * ContentionMaxScale, limits.timeLeft[stm] / ContentionMaxTimeDiv));
+}
+
+// Stolen CPU makes the wall clock count time the search did not get. Under contention the allocated time
+// is compared to the CPU time of the search thread instead, within the maximum time
+bool SearchData::allocatedTimeIsUp(TimeMs elapsed) {
+    if (elapsed < allocatedTime) return false;
+    if (limits.nodesTime > 0 || elapsed >= maximumTime) return true;
+
+    updateContention();
+    return contention < ContentionThreshold || cpuTime >= allocatedTime;
+}
+
+void SearchData::updateContention() {
+    TimeMs wallTime = now() - startTime;
+
+    cpuTime = threadCpuTime() - cpuStartTime;
+    contention = wallTime > 0 ? std::clamp(1.0 - double(cpuTime) / wallTime, 0.0, 1.0) : 0.0;
 }
 
 void Engine::waitForSearchFinish() {
@@ -42,13 +83,19 @@ void Engine::waitForSearchFinish() {
 void Engine::search(const SearchLimits &limits) {
     if (searching) return;
 
-    sd = std::make_unique<SearchData>(position(), limits);
+    auto data = std::make_unique<SearchData>(position(), limits);
+    if (keepMoveHistory && sd) data->moveHistory = sd->moveHistory;
+
+    sd = std::move(data);
     aborted = false;
     searching = true;
     
     tt.newSearch();
 
     std::thread th([&] { 
+        if (trackSearchStack) searchStackWatermark.paint();
+        sd->cpuStartTime = threadCpuTime();
+        this->onSearchStart();
         this->idSearch();
     });
     th.detach();
@@ -58,12 +105,52 @@ void Engine::stop() {
     aborted = true;
 }
 
+Score Engine::quiescence(MoveList &pv) {
+    if (searching) return SCORE_NONE;
+
+    sd = std::make_unique<SearchData>(position(), SearchLimits());
+    aborted = false;
+
+    return rootPosition.getSideToMove() == WHITE
+         ? qSearch<WHITE, NodeType::PV>(-SCORE_INFINITE, SCORE_INFINITE, 0, 0, pv)
+         : qSearch<BLACK, NodeType::PV>(-SCORE_INFINITE, SCORE_INFINITE, 0, 0, pv);
+}
+
+void Engine::memoryUsage(MemoryReport &report) const {
+    report.add("lmr table", sizeof(LMRTable));
+    report.add("engine", sizeof(Engine) - sizeof(Position));
+    report.add("root position", sizeof(Position));
+    report.add("search position", sd ? sizeof(Position) : 0, true);
+    report.add("move history", sd ? sizeof(MoveHistory) : 0, true);
+    report.add("search data", sd ? sizeof(SearchData) - sizeof(Position) - sizeof(MoveHistory) : 0, true);
+    report.add("transposition table", tt.memory(), true);
+    report.add("mate table", mateTable ? mateTable->memory() : 0, true);
+}
+
+#ifdef INSTRUMENT
+bool Engine::recordTree(const std::string &filename, int maxPly, size_t maxNodes) {
+    if (searching) return false;
+
+    treeRecorder = std::make_unique<TreeRecorder>();
+    if (!treeRecorder->open(filename, maxPly, maxNodes)) {
+        treeRecorder.reset();
+        return false;
+    }
+
+    return true;
+}
+#endif
+
 // Iterative deepening loop
 template<Side Me>
 void Engine::idSearch() {
     MoveList bestPv;
-    Score bestScore;
-    int depth, searchDepth, completedDepth = 0;
+    Score bestScore = SCORE_NONE;
+    int depth, searchDepth, completedDepth = 0, mateIterations = 0;
+
+    MoveList rootMoves;
+    generateLegalMoves(sd->position, rootMoves);
+    size_t nbRootMoves = sd->limits.searchMoves.size() > 0 ? sd->limits.searchMoves.size() : rootMoves.size();
 
     for (depth = 1; depth < MAX_PLY; depth++) {
         Score alpha = -SCORE_INFINITE, beta = SCORE_INFINITE;
@@ -76,8 +163,8 @@ void Engine::idSearch() {
         searchDepth = depth;
 
         // Aspiration window
-        if (depth > 4) {
-            delta = 16 + std::abs(bestScore)/100;
+        if (depth >= AspirationMinDepth) {
+            delta = AspirationDelta + std::abs(bestScore)/AspirationScoreDiv;
             alpha = std::max(-SCORE_INFINITE, bestScore - delta);
             beta  = std::min( SCORE_INFINITE, bestScore + delta);
         }
@@ -109,6 +196,9 @@ void Engine::idSearch() {
 
         if (depth > 1 && searchAborted()) break;
 
+        bool isMate = std::abs(score) >= SCORE_MATE_MAX_PLY;
+        mateIterations = isMate && completedDepth > 0 && score == bestScore ? mateIterations + 1 : isMate;
+
         bestPv = pv;
         bestScore = score;
         completedDepth = depth;
@@ -116,16 +206,262 @@ void Engine::idSearch() {
         onSearchProgress(SearchEvent(depth, sd->selDepth, pv, bestScore, sd->nbNodes, sd->getElapsed(), tt.usage()));
 
         if (sd->limits.maxDepth > 0 && depth >= sd->limits.maxDepth) break;
+
+        // No need to spend the allocated time when the result is already known
+        if (sd->useTournamentTime()) {
+            if (nbRootMoves == 1)
+                sd->stopReason = STOP_SINGLE_MOVE;
+            else if (mateIterations >= MateConfirmIterations && depth >= SCORE_MATE - std::abs(bestScore))
+                sd->stopReason = STOP_MATE;
+            else if (depth >= OnlyMoveMinDepth && sd->rootNonLosingMoves == 1 && bestScore > -SCORE_MATE_MAX_PLY)
+                sd->stopReason = STOP_ONLY_MOVE;
+
+            if (sd->stopReason != STOP_NONE) break;
+        }
     }
 
     SearchEvent event(depth, sd->selDepth, bestPv, bestScore, sd->nbNodes, sd->getElapsed(), tt.usage());
+    sd->updateContention();
+    event.completedDepth = completedDepth;
+    event.stopReason = sd->stopReason != STOP_NONE ? sd->stopReason
+                     : searchAborted() ? STOP_COMMAND
+                     : depth < MAX_PLY ? STOP_DEPTH : STOP_MAX_PLY;
     if (depth != completedDepth)
         onSearchProgress(event);
+
+    finishSearch(event);
+}
+
+// Common to the end of every search, from the search thread
+void Engine::finishSearch(SearchEvent &event) {
+#ifdef INSTRUMENT
+    flushInstrumentStats();
+
+    // The recorder is armed for a single search
+    if (treeRecorder) {
+        treeRecorder->close();
+        treeRecorder.reset();
+    }
+#endif
+    if (trackSearchStack) searchStackWatermark.measure();
+
     onSearchFinish(event);
 
     searching = false;
 }
 
+// Mate search, "go mate N": iterative deepening on the number of attacker moves, every node is either proven
+// or refuted, so there is no evaluation, no eval-based pruning and the distance to mate bounds the depth.
+// Repetitions and the 50 moves rule are ignored. Without a mate, a regular search chooses and scores the move
+template<Side Me>
+void Engine::mateSearch() {
+    MoveList bestPv;
+    int maxMoves = std::min(sd->limits.mate, MAX_PLY / 2);
+    int mateIn = 0;
+
+    if (!mateTable) mateTable = std::make_unique<MateTable>();
+    mateTable->clear();
+
+    for (int n = 1; n <= maxMoves; n++) {
+        sd->selDepth = 0;
+        bool mate = mateAttack<Me>(n, 0, bestPv);
+
+        if (searchAborted()) break;
+        if (mate) {
+            mateIn = n;
+            break;
+        }
+    }
+
+    // The regular search goes on with the time left, or a few plies when there is no other limit. Stopped, it
+    // still runs its first iteration for a move with a score
+    if (mateIn == 0) {
+        if (searchAborted()) {
+            sd->limits.maxDepth = 1;
+            aborted = false;
+        } else if (!sd->useTimeLimit() && !sd->useNodeCountLimit() && sd->limits.maxDepth == 0) {
+            sd->limits.maxDepth = MateFallbackDepth;
+        }
+
+        idSearch<Me>();
+        return;
+    }
+
+    int depth = 2 * mateIn - 1;
+    Score score = SCORE_MATE - depth;
+
+    // The pv stops at the first mate table hit, the rest of the proof is in the table
+    Position &pos = sd->position;
+    MoveList played = bestPv;
+
+    for (Move move : played) pos.doMove(move);
+
+    while (int(bestPv.size()) < depth) {
+        Move move = mateTable->proof(pos.hash());
+        if (move == MOVE_NONE || !pos.isLegal(move)) break;
+
+        bestPv.push_back(move);
+        played.push_back(move);
+        pos.doMove(move);
+    }
+
+    for (auto it = played.end(); it != played.begin(); ) pos.undoMove(*--it);
+
+    SearchEvent event(depth, sd->selDepth, bestPv, score, sd->nbNodes, sd->getElapsed(), 0);
+    sd->updateContention();
+    event.completedDepth = depth;
+    event.stopReason = STOP_MATE_PROVEN;
+    onSearchProgress(event);
+
+    finishSearch(event);
+}
+
+// Attacker to move, true when it mates in at most n moves
+template<Side Me>
+bool Engine::mateAttack(int n, int ply, MoveList &pv) {
+    Position &pos = sd->position;
+    uint64_t hash = pos.hash();
+    bool mate;
+    Move ttMove;
+
+    if (sd->shouldStop()) stop();
+    if (searchAborted()) return false;
+
+    sd->selDepth = std::max(sd->selDepth, ply);
+
+    // No probe at the root to always get a pv
+    if (ply > 0 && mateTable->probe(hash, n, mate, ttMove)) {
+        pv.clear();
+        if (mate) pv.push_back(ttMove);
+        return mate;
+    }
+
+    // Checks first, the fewer evasions the better, then captures. Only checks can mate with the last move
+    struct Candidate { Move move; int order; };
+    fixed_vector<Candidate, MAX_MOVE, uint8_t> candidates;
+    MoveList moves;
+
+    enumerateLegalMoves<Me>(pos, [&](Move m) {
+        if (ply > 0 || sd->limits.searchMoves.size() == 0 || sd->limits.searchMoves.contains(m))
+            moves.push_back(m);
+        return true;
+    });
+
+    for (Move move : moves) {
+        bool capture = pos.isCapture(move);
+
+        pos.doMove<Me>(move);
+        sd->nbNodes++;
+
+        int evasions = -1;
+        if (pos.inCheck()) {
+            evasions = 0;
+            enumerateLegalMoves<~Me>(pos, [&](Move) { evasions++; return true; });
+        }
+
+        pos.undoMove<Me>(move);
+
+        if (evasions == 0) {
+            mateTable->store(hash, 1, true, move);
+            pv.clear();
+            pv.push_back(move);
+            return true;
+        }
+
+        if (evasions > 0)
+            candidates.push_back({ move, evasions });
+        else if (n > 1)
+            candidates.push_back({ move, capture ? MAX_MOVE : 2 * MAX_MOVE });
+    }
+
+    if (n > 1) {
+        std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b) {
+            return a.order < b.order;
+        });
+
+        for (const Candidate &candidate : candidates) {
+            MoveList childPv;
+
+            pos.doMove<Me>(candidate.move);
+            sd->nbNodes++;
+
+            mate = mateDefend<~Me>(n - 1, ply + 1, childPv);
+
+            pos.undoMove<Me>(candidate.move);
+
+            if (searchAborted()) return false;
+
+            if (mate) {
+                mateTable->store(hash, n, true, candidate.move);
+                updatePv(pv, candidate.move, childPv);
+                return true;
+            }
+        }
+    }
+
+    mateTable->store(hash, n, false, MOVE_NONE);
+    return false;
+}
+
+// Defender to move, true when every move is mated by the attacker in at most n moves
+template<Side Me>
+bool Engine::mateDefend(int n, int ply, MoveList &pv) {
+    Position &pos = sd->position;
+    uint64_t hash = pos.hash();
+    bool mate;
+    Move ttMove;
+
+    if (searchAborted()) return false;
+
+    sd->selDepth = std::max(sd->selDepth, ply);
+
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+
+    // Mated or stalemate
+    if (moves.empty()) return pos.inCheck();
+    if (n == 0) return false;
+
+    if (mateTable->probe(hash, n, mate, ttMove)) {
+        pv.clear();
+        if (mate) pv.push_back(ttMove);
+        return mate;
+    }
+
+    // Captures are the most likely to refute
+    std::stable_partition(moves.begin(), moves.end(), [&](Move m) { return pos.isCapture(m); });
+
+    Move defence = MOVE_NONE;
+    pv.clear();
+
+    for (Move move : moves) {
+        MoveList childPv;
+
+        pos.doMove<Me>(move);
+        sd->nbNodes++;
+
+        mate = mateAttack<~Me>(n, ply + 1, childPv);
+
+        pos.undoMove<Me>(move);
+
+        if (searchAborted()) return false;
+
+        if (!mate) {
+            mateTable->store(hash, n, false, move);
+            return false;
+        }
+
+        // Every defence is part of the proof, the longest resistance found is reported
+        if (childPv.size() + 1 > pv.size()) {
+            defence = move;
+            updatePv(pv, move, childPv);
+        }
+    }
+
+    mateTable->store(hash, n, true, defence);
+    return true;
+}
+
 // Negamax search
 template<Side Me, NodeType NT>
 Score Engine::pvSearch(Score alpha, Score beta, int depth, int ply, MoveList &pv, bool cutNode) {
@@ -135,9 +471,11 @@ Score Engine::pvSearch(Score alpha, Score beta, int depth, int ply, MoveList &pv
 
     // Quiescence
     if (depth <= 0) {
-        return qSearch<Me, QNodeType>(alpha, beta, depth, ply);
+        return qSearch<Me, QNodeType>(alpha, beta, depth, ply, pv);
     }
 
+    TREE_NODE(RootNode ? TREE_ROOT : PvNode ? TREE_PV : TREE_NON_PV);
+
     // Update selDepth
     if (PvNode && sd->selDepth < ply + 1) {
         sd->selDepth = ply + 1;
@@ -150,7 +488,7 @@ Score Engine::pvSearch(Score alpha, Score beta, int depth, int ply, MoveList &pv
 
     // If search has been aborted (either by the gui or by reaching limits) exit here
     if (!RootNode && searchAborted()) [[unlikely]] {
-        return -SCORE_INFINITE;
+        TREE_RETURN(-SCORE_INFINITE, TREE_ABORTED);
     }
 
     // Mate distance pruning
@@ -158,7 +496,7 @@ Score Engine::pvSearch(Score alpha, Score beta, int depth, int ply, MoveList &pv
         alpha = std::max(alpha, -SCORE_MATE + ply);
         beta  = std::min(beta, SCORE_MATE - ply - 1);
 
-        if (alpha >= beta) return alpha;
+        if (alpha >= beta) TREE_RETURN(alpha, TREE_MATE_DISTANCE);
     }
 
     Score alphaOrig = alpha;
@@ -171,12 +509,12 @@ Score Engine::pvSearch(Score alpha, Score beta, int depth, int ply, MoveList &pv
 
     if (pos.isFiftyMoveDraw() || pos.isMaterialDraw() || pos.isRepetitionDraw()) {
         // "Random" either -1 or 1, avoid blindness to 3-fold repetitions
-        return 1-(sd->nbNodes & 2);
+        TREE_RETURN(1-(sd->nbNodes & 2), TREE_DRAW);
         //return SCORE_DRAW;
     }
 
     if (ply >= MAX_PLY) [[unlikely]] {
-        return evaluate<Me>(pos); // TODO: verify if we are in check ?
+        TREE_RETURN(evaluate<Me>(pos), TREE_MAX_PLY); // TODO: verify if we are in check ?
     }
 
     // Query Transposition Table
@@ -185,10 +523,11 @@ Score Engine::pvSearch(Score alpha, Score beta, int depth, int ply, MoveList &pv
     bool ttPv = PvNode || (ttHit && tte->isPv());
     Move ttMove = ttHit ? tte->move() : MOVE_NONE;
     bool ttTactical = ttHit ? pos.isTactical(ttMove) : false;
+    TREE_TT_HIT(ttHit);
 
     // Transposition Table cutoff
     if (!PvNode && ttHit && tte->depth() >= depth && tte->canCutoff(ttScore, beta)) {
-        return ttScore;
+        TREE_RETURN(ttScore, TREE_TT_CUTOFF);
     }
 
     // Static eval
@@ -212,19 +551,19 @@ Score Engine::pvSearch(Score alpha, Score beta, int depth, int ply, MoveList &pv
     }
 
     // Reverse futility pruning (RFP)
-    if (!PvNode && !inCheck && depth <= 4
-        && eval - (100 * depth) >= beta)
+    if (!PvNode && !inCheck && depth <= RfpMaxDepth
+        && eval - (RfpMargin * depth) >= beta)
     {
-        return eval;
+        TREE_RETURN(eval, TREE_RFP);
     }
 
     // Razoring
-    if (!PvNode && !inCheck && depth <= 2
-        && eval + (400 * depth) <= alpha)
+    if (!PvNode && !inCheck && depth <= RazorMaxDepth
+        && eval + (RazorMargin * depth) <= alpha)
     {
-        Score score = qSearch<Me, QNodeType>(alpha, beta, depth, ply);
+        Score score = qSearch<Me, QNodeType>(alpha, beta, depth, ply, childPv);
         if (score <= alpha)
-            return score;
+            TREE_RETURN(score, TREE_RAZORING);
     }
 
     // Null move pruning (NMP)
@@ -232,7 +571,7 @@ Score Engine::pvSearch(Score alpha, Score beta, int depth, int ply, MoveList &pv
         && pos.previousMove() != MOVE_NULL && pos.hasNonPawnMateriel<Me>() && eval >= beta)
     {
         tt.prefetch(pos.getHashAfterNullMove());
-        int R = 4 + depth / 4;
+        int R = NmpBase + depth / NmpDepthDiv;
 
         pos.doNullMove<Me>();
         Score score = -pvSearch<~Me, NodeType::NonPV>(-beta, -beta+1, depth-R, ply+1, childPv, !cutNode);
@@ -240,7 +579,7 @@ Score Engine::pvSearch(Score alpha, Score beta, int depth, int ply, MoveList &pv
 
         if (score >= beta) {
             // TODO: verification search ?
-            return score >= SCORE_MATE_MAX_PLY ? beta : score;
+            TREE_RETURN(score >= SCORE_MATE_MAX_PLY ? beta : score, TREE_NMP);
         }
     }
 
@@ -252,7 +591,8 @@ Score Engine::pvSearch(Score alpha, Score beta, int depth, int ply, MoveList &pv
     sd->moveHistory.clearKillers(ply+1);
 
     int nbMoves = 0;
-    MovePicker<MAIN, Me> mp(pos, ttMove, &sd->moveHistory, ply);
+    MovePicker<MAIN, Me> mp(pos, ttMove, &sd->moveHistory, ply, &tt);
+    if (RootNode) sd->rootNonLosingMoves = 0;
     PartialMoveList quietMoves;
     
     mp.enumerate([&](Move move, bool& skipQuiets) -> bool {
@@ -267,10 +607,10 @@ Score Engine::pvSearch(Score alpha, Score beta, int depth, int ply, MoveList &pv
         // Late move pruning
         if (!RootNode && bestScore > -SCORE_MATE_MAX_PLY) {
             // Move count pruning
-            skipQuiets = (nbMoves >= 3 + depth*depth);
+            skipQuiets = (nbMoves >= LmpBase + depth*depth);
 
             // SEE Pruning
-            if (depth <= 8 && !pos.see(move, moveIsTactical ? -100*depth : -60*depth)) {
+            if (depth <= SeeMaxDepth && !pos.see(move, moveIsTactical ? -SeeTacticalMargin*depth : -SeeQuietMargin*depth)) {
                 return true; // continue;
             }
         }
@@ -322,6 +662,9 @@ Score Engine::pvSearch(Score alpha, Score beta, int depth, int ply, MoveList &pv
 
         if (searchAborted()) return false; // break
 
+        // Fail low scores are upper bounds, a mated one proves the move lost
+        if (RootNode) sd->rootNonLosingMoves += score > -SCORE_MATE_MAX_PLY;
+
         if (score > bestScore) {
             bestScore = score;
             
@@ -332,6 +675,9 @@ Score Engine::pvSearch(Score alpha, Score beta, int depth, int ply, MoveList &pv
                     updatePv(pv, move, childPv);
 
                 if (alpha >= beta) {
+#ifdef INSTRUMENT
+                    recordCutoff(mp.stage(), mp.stageIndex(), nbMoves, depth);
+#endif
                     sd->moveHistory.update<Me>(pos, bestMove, ply, depth, quietMoves);
                     return false; // break
                 }
@@ -343,11 +689,11 @@ Score Engine::pvSearch(Score alpha, Score beta, int depth, int ply, MoveList &pv
         }
 
         return true;
-    }); if (searchAborted()) return bestScore;
+    }); if (searchAborted()) TREE_RETURN(bestScore, TREE_ABORTED);
 
     // Checkmate / Stalemate detection
     if (nbMoves == 0) {
-        return inCheck ? -SCORE_MATE + ply : SCORE_DRAW;
+        TREE_RETURN(inCheck ? -SCORE_MATE + ply : SCORE_DRAW, TREE_NO_MOVE);
     }
 
     // Update Transposition Table
@@ -355,14 +701,19 @@ Score Engine::pvSearch(Score alpha, Score beta, int depth, int ply, MoveList &pv
                     !PvNode || bestScore <= alphaOrig ? BOUND_UPPER : BOUND_EXACT;
     tt.set(tte, pos.hash(), depth, ply, ttBound, bestMove, SCORE_NONE, bestScore, ttPv);
 
-    return bestScore;
+    TREE_RETURN(bestScore, TREE_SEARCHED);
 }
 
 // Quiescence search
 template<Side Me, NodeType NT>
-Score Engine::qSearch(Score alpha, Score beta, int depth, int ply) {
+Score Engine::qSearch(Score alpha, Score beta, int depth, int ply, MoveList &pv) {
     constexpr bool PvNode = (NT != NodeType::NonPV);
 
+    TREE_NODE(PvNode ? TREE_QS_PV : TREE_QS_NON_PV);
+
+    if (PvNode)
+        pv.clear();
+
     // Check if we should stop according to limits
     if (sd->shouldStop()) [[unlikely]] {
         stop();
@@ -370,22 +721,23 @@ Score Engine::qSearch(Score alpha, Score beta, int depth, int ply) {
 
     // If search has been aborted (either by the gui or by limits) exit here
     if (searchAborted()) [[unlikely]] {
-        return -SCORE_INFINITE;
+        TREE_RETURN(-SCORE_INFINITE, TREE_ABORTED);
     }
 
     // Default bestScore for mate detection, if InCheck and there is no move this score will be returned
     Score bestScore = -SCORE_MATE + ply;
     Move bestMove = MOVE_NONE;
     Position &pos = sd->position;
+    MoveList childPv;
 
     if (pos.isFiftyMoveDraw() || pos.isMaterialDraw() || pos.isRepetitionDraw()) {
         // "Random" either -1 or 1, avoid blindness to 3-fold repetitions
-        return 1-(sd->nbNodes & 2);
+        TREE_RETURN(1-(sd->nbNodes & 2), TREE_DRAW);
         //return SCORE_DRAW;
     }
 
     if (ply >= MAX_PLY) [[unlikely]] {
-        return evaluate<Me>(pos); // TODO: check if we are in check ?
+        TREE_RETURN(evaluate<Me>(pos), TREE_MAX_PLY); // TODO: check if we are in check ?
     }
 
     bool inCheck = pos.inCheck();
@@ -396,10 +748,11 @@ Score Engine::qSearch(Score alpha, Score beta, int depth, int ply) {
     bool ttPv = PvNode || (ttHit && tte->isPv());
     int ttDepth = inCheck ? 1 : 0; // If we are in check use depth=1 because when we are in check we go through all moves
     Score ttScore = tte->score(ply);
+    TREE_TT_HIT(ttHit);
 
     // Transposition Table cutoff
     if (!PvNode && ttHit && tte->depth() >= ttDepth && tte->canCutoff(ttScore, beta)) {
-        return ttScore;
+        TREE_RETURN(ttScore, TREE_TT_CUTOFF);
     }
 
     // Standing Pat
@@ -417,7 +770,7 @@ Score Engine::qSearch(Score alpha, Score beta, int depth, int ply) {
         }
 
         if (eval >= beta) {
-            return eval;
+            TREE_RETURN(eval, TREE_STAND_PAT);
         }
 
         if (eval > alpha)
@@ -430,7 +783,7 @@ Score Engine::qSearch(Score alpha, Score beta, int depth, int ply) {
     Move ttMove = tte->move();
     // If ttMove is quiet we don't want to use it past a certain depth to allow qSearch to stabilize
     bool useTTMove = ttHit && isValidMove(ttMove) && (depth >= -7 || pos.inCheck() || pos.isTactical(ttMove));
-    MovePicker<QUIESCENCE, Me> mp(pos, useTTMove ? ttMove : MOVE_NONE);
+    MovePicker<QUIESCENCE, Me> mp(pos, useTTMove ? ttMove : MOVE_NONE, &tt);
 
     mp.enumerate([&](Move move, /*unused*/bool& skipQuiets) -> bool {
         //nbMoves++;
@@ -441,7 +794,7 @@ Score Engine::qSearch(Score alpha, Score beta, int depth, int ply) {
         sd->nbNodes++;
 
         pos.doMove<Me>(move);
-        Score score = -qSearch<~Me, NT>(-beta, -alpha, depth-1, ply+1);
+        Score score = -qSearch<~Me, NT>(-beta, -alpha, depth-1, ply+1, childPv);
         pos.undoMove<Me>(move);
 
         if (searchAborted()) return false; // break
@@ -452,6 +805,8 @@ Score Engine::qSearch(Score alpha, Score beta, int depth, int ply) {
             if (bestScore > alpha) {
                 bestMove = move;
                 alpha = bestScore;
+                if (PvNode)
+                    updatePv(pv, move, childPv);
 
                 if (alpha >= beta) {
                     return false; // break
@@ -460,13 +815,13 @@ Score Engine::qSearch(Score alpha, Score beta, int depth, int ply) {
         }
 
         return true;
-    }); if (searchAborted()) return bestScore;
+    }); if (searchAborted()) TREE_RETURN(bestScore, TREE_ABORTED);
 
     // Update Transposition Table
     Bound ttBound = bestScore >= beta ? BOUND_LOWER : BOUND_UPPER;
     tt.set(tte, pos.hash(), ttDepth, ply, ttBound, bestMove, eval, bestScore, ttPv);
 
-    return bestScore;
+    TREE_RETURN(bestScore, TREE_SEARCHED);
 }
 
 } /* namespace Belette */
\ No newline at end of file
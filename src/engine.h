@@ -7,6 +7,9 @@
 #include "movegen.h"
 #include "movehistory.h"
 #include "tt.h"
+#include "matetable.h"
+#include "treerecorder.h"
+#include "memory.h"
 #include "utils.h"
 
 namespace Belette {
@@ -18,9 +21,27 @@ struct SearchLimits {
     int maxDepth = 0;
     size_t maxNodes = 0;
     TimeMs maxTime = 0;
+    int64_t nodesTime = 0; // Virtual clock in nodes per millisecond, 0 for the wall clock
+    int mate = 0;          // Mate search in at most that many moves, 0 for the regular search
     MoveList searchMoves;
 };
 
+// Why the iterative deepening loop ended
+enum StopReason {
+    STOP_NONE,
+    STOP_DEPTH,       // "go depth" reached
+    STOP_MAX_PLY,
+    STOP_TIME,        // Allocated time of the tournament time control
+    STOP_MOVETIME,
+    STOP_NODES,
+    STOP_SINGLE_MOVE, // Fast paths of the time manager: one legal move,
+    STOP_MATE,        // mate score confirmed over several iterations,
+    STOP_ONLY_MOVE,   // all the other moves are proven lost
+    STOP_MATE_PROVEN, // "go mate" found a mate
+    STOP_COMMAND,     // Stopped by the GUI
+    NB_STOP_REASON
+};
+
 struct SearchData {
     SearchData(const Position& pos_, const SearchLimits& limits_)
     : position(pos_), limits(limits_), nbNodes(0) {
@@ -28,32 +49,37 @@ struct SearchData {
     }
 
     void initAllocatedTime();
+    bool allocatedTimeIsUp(TimeMs elapsed);
+    void updateContention(); // From the search thread
 
-    inline TimeMs getElapsed() { return now() - startTime; }
+    // The virtual clock makes the time decisions deterministic and independent of the load
+    inline TimeMs getElapsed() const {
+        return limits.nodesTime > 0 ? TimeMs(nbNodes / limits.nodesTime) : now() - startTime;
+    }
     inline void start() {
         startTime = now();
         initAllocatedTime();
     }
     
-    inline bool useTournamentTime() { return !!(limits.timeLeft[WHITE] | limits.timeLeft[WHITE]); }
+    inline bool useTournamentTime() const { return !!(limits.timeLeft[WHITE] | limits.timeLeft[BLACK]); }
     inline bool useFixedTime() { return limits.maxTime > 0; }
-    inline bool useTimeLimit() { return useTournamentTime() || useTimeLimit(); }
+    inline bool useTimeLimit() { return useTournamentTime() || useFixedTime(); }
     inline bool useNodeCountLimit() { return limits.maxNodes > 0; }
 
     inline bool shouldStop() {
         // Check time every 1024 nodes for performance reason
         if (nbNodes % 1024 != 0)  return false;
         
-        TimeMs elapsed = now() - startTime;
-
-        if (useTournamentTime() && elapsed >= allocatedTime)
-            return true;
-        if (useFixedTime() && (elapsed > limits.maxTime))
-            return true;
-        if (useNodeCountLimit() && nbNodes >= limits.maxNodes)
-            return true;
+        TimeMs elapsed = getElapsed();
+
+        if (useTournamentTime() && allocatedTimeIsUp(elapsed))
+            stopReason = STOP_TIME;
+        else if (useFixedTime() && (elapsed > limits.maxTime))
+            stopReason = STOP_MOVETIME;
+        else if (useNodeCountLimit() && nbNodes >= limits.maxNodes)
+            stopReason = STOP_NODES;
         
-        return false;
+        return stopReason != STOP_NONE;
     }
 
     Position position;
@@ -64,6 +90,13 @@ struct SearchData {
     TimeMs startTime;
     TimeMs lastCheck;
     TimeMs allocatedTime;
+    TimeMs maximumTime;  // Limit of the extension of the allocated time under CPU contention
+    StopReason stopReason = STOP_NONE;
+
+    TimeMs cpuStartTime = 0;
+    TimeMs cpuTime = 0;
+    double contention = 0.0; // Share of the wall time the search thread did not get the CPU
+    int rootNonLosingMoves = 0; // Root moves not proven lost by the last root search
 
     MoveHistory moveHistory;
 };
@@ -79,6 +112,10 @@ struct SearchEvent {
     size_t nbNodes;
     TimeMs elapsed;
     size_t hashfull;
+
+    // Only set for the final event
+    int completedDepth = 0;
+    StopReason stopReason = STOP_NONE;
 };
 
 enum class NodeType {
@@ -103,26 +140,67 @@ public:
     inline bool isSearching() { return searching; }
     inline bool searchAborted() { return aborted; }
     inline void setHashSize(size_t size) { tt.resize(size); }
-    inline void newGame() { tt.clear(); }
+    inline size_t hashSize() const { return tt.memory(); }
+    // A running search still uses the search data, it is stopped first
+    inline void newGame() { stop(); waitForSearchFinish(); tt.clear(); sd.reset(); }
+
+    // Keep killers, counter moves & history from one search to the next one
+    inline void setKeepMoveHistory(bool keep) { keepMoveHistory = keep; }
+
+    // Paint the stack of the search threads to measure their high-water mark
+    inline void setTrackSearchStack(bool track) { trackSearchStack = track; }
+    inline const StackWatermark &searchStack() const { return searchStackWatermark; }
+
+    // Structures owned by the engine
+    void memoryUsage(MemoryReport &report) const;
+
+    // Synchronous quiescence search of the current position with fresh search data
+    Score quiescence(MoveList &pv);
+
+#ifdef INSTRUMENT
+    // Record the tree of the next search, up to maxPly and maxNodes nodes
+    bool recordTree(const std::string &filename, int maxPly, size_t maxNodes);
+#endif
 
 protected:
+    virtual void onSearchStart() { } // Called from the search thread
     virtual void onSearchProgress(const SearchEvent &event) = 0;
     virtual void onSearchFinish(const SearchEvent &event) = 0;
 
+    // Data of the current search, valid from the search thread callbacks
+    inline const SearchData &searchData() const { return *sd; }
+
 private:
     static int LMRTable[MAX_PLY][MAX_MOVE];
 
     std::unique_ptr<SearchData> sd;
+    TranspositionTable tt;
     Position rootPosition;
     bool aborted = true;
     bool searching = false;
-
-    inline void idSearch() { rootPosition.getSideToMove() == WHITE ? idSearch<WHITE>() : idSearch<BLACK>(); }
+    bool keepMoveHistory = false;
+    bool trackSearchStack = false;
+    StackWatermark searchStackWatermark;
+    std::unique_ptr<MateTable> mateTable; // Allocated by the first mate search
+
+#ifdef INSTRUMENT
+    std::unique_ptr<TreeRecorder> treeRecorder;
+#endif
+
+    inline void idSearch() {
+        if (sd->limits.mate > 0) rootPosition.getSideToMove() == WHITE ? mateSearch<WHITE>() : mateSearch<BLACK>();
+        else rootPosition.getSideToMove() == WHITE ? idSearch<WHITE>() : idSearch<BLACK>();
+    }
     template<Side Me> void idSearch();
+    void finishSearch(SearchEvent &event);
+
+    template<Side Me> void mateSearch();
+    template<Side Me> bool mateAttack(int n, int ply, MoveList &pv);
+    template<Side Me> bool mateDefend(int n, int ply, MoveList &pv);
 
     template<Side Me, NodeType NT> Score pvSearch(Score alpha, Score beta, int depth, int ply, MoveList &pv, bool cutNode);
 
-    template<Side Me, NodeType NT> Score qSearch(Score alpha, Score beta, int depth, int ply);
+    template<Side Me, NodeType NT> Score qSearch(Score alpha, Score beta, int depth, int ply, MoveList &pv);
 };
 
 } /* namespace Belette */
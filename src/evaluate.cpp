@@ -51,6 +51,8 @@ Score evaluate(const Position &pos) {
 
 template<Side Me>
 Score evaluate(const Position &pos) {
+    INSTRUMENT_SCOPE(REGION_EVALUATE);
+
     Score mg = evaluate<Me, MG>(pos);
     Score eg = evaluate<Me, EG>(pos);
 
@@ -0,0 +1,131 @@
+#include <mutex>
+#include <iomanip>
+#include "instrument.h"
+#include "uci.h"
+
+namespace Belette {
+
+#ifdef INSTRUMENT
+
+thread_local InstrumentStats threadInstrumentStats;
+
+static InstrumentStats globalStats;
+static std::mutex globalStatsMutex;
+
+void flushInstrumentStats() {
+    std::lock_guard<std::mutex> lock(globalStatsMutex);
+
+    for (int i = 0; i < NB_INSTRUMENT_REGION; i++) {
+        globalStats.regions[i].cycles += threadInstrumentStats.regions[i].cycles;
+        globalStats.regions[i].calls += threadInstrumentStats.regions[i].calls;
+    }
+
+    for (int s = 0; s < NB_PICK_STAGE; s++)
+        for (int i = 0; i < NB_STAGE_INDEX; i++)
+            globalStats.ordering.cutoffs[s][i] += threadInstrumentStats.ordering.cutoffs[s][i];
+
+    for (int d = 0; d < NB_CUTOFF_DEPTH; d++)
+        for (int b = 0; b < NB_CUTOFF_BUCKET; b++)
+            globalStats.ordering.cutoffsByDepth[d][b] += threadInstrumentStats.ordering.cutoffsByDepth[d][b];
+
+    threadInstrumentStats = InstrumentStats();
+}
+
+void resetInstrumentStats() {
+    std::lock_guard<std::mutex> lock(globalStatsMutex);
+    globalStats = InstrumentStats();
+}
+
+// Cost of an empty scoped timer, included in every measure
+static double timerOverhead() {
+    constexpr int NbCalls = 100000;
+    InstrumentStats saved = threadInstrumentStats;
+    threadInstrumentStats = InstrumentStats();
+
+    for (int i = 0; i < NbCalls; i++) {
+        INSTRUMENT_SCOPE(REGION_GEN_ALL);
+    }
+
+    double overhead = double(threadInstrumentStats.regions[REGION_GEN_ALL].cycles) / NbCalls;
+    threadInstrumentStats = saved;
+
+    return overhead;
+}
+
+static void printOrderingReport(const OrderingStats &stats) {
+    static const char *stageNames[NB_PICK_STAGE] = {
+        "tt", "good tactical", "killer 1", "killer 2", "counter", "good quiet", "bad tactical", "bad quiet", "evasion"
+    };
+
+    uint64_t total = 0, firstMove = 0;
+    for (int d = 0; d < NB_CUTOFF_DEPTH; d++) {
+        firstMove += stats.cutoffsByDepth[d][0];
+        for (int b = 0; b < NB_CUTOFF_BUCKET; b++) total += stats.cutoffsByDepth[d][b];
+    }
+
+    if (!total) return;
+
+    console << std::endl << "Beta cutoffs: " << total << ", first move " << std::fixed << std::setprecision(1)
+            << 100.0 * firstMove / total << "%" << std::endl;
+
+    // Share of the cutoffs by stage, then by index of the move in the stage
+    console << std::endl << "Stage              total     #1     #2     #3     #4     #5     #6     #7    #8+" << std::endl;
+
+    for (int s = 0; s < NB_PICK_STAGE; s++) {
+        uint64_t stageTotal = 0;
+        for (int i = 0; i < NB_STAGE_INDEX; i++) stageTotal += stats.cutoffs[s][i];
+
+        console << std::left << std::setw(15) << stageNames[s] << std::right << std::setw(9) << 100.0 * stageTotal / total << "%";
+        for (int i = 0; i < NB_STAGE_INDEX; i++)
+            console << std::setw(7) << 100.0 * stats.cutoffs[s][i] / total;
+        console << std::endl;
+    }
+
+    // Move number of the cutoff, for each depth
+    console << std::endl << "Depth     cutoffs      1      2      3    4-5   6-10    11+" << std::endl;
+
+    for (int d = 0; d < NB_CUTOFF_DEPTH; d++) {
+        uint64_t depthTotal = 0;
+        for (int b = 0; b < NB_CUTOFF_BUCKET; b++) depthTotal += stats.cutoffsByDepth[d][b];
+        if (!depthTotal) continue;
+
+        console << std::setw(4) << (d + 1) << (d + 1 == NB_CUTOFF_DEPTH ? "+" : " ") << std::setw(12) << depthTotal;
+        for (int b = 0; b < NB_CUTOFF_BUCKET; b++)
+            console << std::setw(7) << 100.0 * stats.cutoffsByDepth[d][b] / depthTotal;
+        console << std::endl;
+    }
+
+    console << std::defaultfloat;
+}
+
+void printInstrumentReport(size_t nbNodes) {
+    static const char *names[NB_INSTRUMENT_REGION] = {
+        "gen all", "gen tacticals", "gen quiets", "doMove", "undoMove",
+        "updateBitboards", "evaluate", "see", "tt probe", "tt store"
+    };
+
+    std::lock_guard<std::mutex> lock(globalStatsMutex);
+    nbNodes = std::max<size_t>(nbNodes, 1);
+
+    console << std::endl << "Region              calls/node   cycles/call   cycles/node" << std::endl;
+
+    for (int i = 0; i < NB_INSTRUMENT_REGION; i++) {
+        const RegionStats &stats = globalStats.regions[i];
+
+        console << std::left << std::setw(18) << names[i] << std::right << std::fixed << std::setprecision(2)
+                << std::setw(12) << double(stats.calls) / nbNodes
+                << std::setw(14) << (stats.calls ? double(stats.cycles) / stats.calls : 0.0)
+                << std::setw(14) << double(stats.cycles) / nbNodes << std::endl;
+    }
+
+    console << "Regions are inclusive (doMove contains updateBitboards), timer overhead "
+            << std::setprecision(1) << timerOverhead() << " cycles per call" << std::defaultfloat << std::endl;
+
+    printOrderingReport(globalStats.ordering);
+
+    globalStats = InstrumentStats();
+}
+
+#endif
+
+} /* namespace Belette */
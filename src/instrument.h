@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+namespace Belette {
+
+enum InstrumentRegion {
+    REGION_GEN_ALL,       // Evasions in search
+    REGION_GEN_TACTICALS,
+    REGION_GEN_QUIETS,
+    REGION_DO_MOVE,
+    REGION_UNDO_MOVE,
+    REGION_UPDATE_BITBOARDS,
+    REGION_EVALUATE,
+    REGION_SEE,
+    REGION_TT_PROBE,
+    REGION_TT_STORE,
+    NB_INSTRUMENT_REGION
+};
+
+// Move picker stage a move comes from, for the move ordering statistics
+enum PickStage {
+    PICK_TT,
+    PICK_GOOD_TACTICAL,
+    PICK_KILLER1,
+    PICK_KILLER2,
+    PICK_COUNTER,
+    PICK_GOOD_QUIET,
+    PICK_BAD_TACTICAL,
+    PICK_BAD_QUIET,
+    PICK_EVASION,
+    NB_PICK_STAGE
+};
+
+#ifdef INSTRUMENT
+
+constexpr int NB_STAGE_INDEX = 8;       // Last one is "8 and more"
+constexpr int NB_CUTOFF_DEPTH = 16;     // Last one is "16 and more"
+constexpr int NB_CUTOFF_BUCKET = 6;     // Move number: 1, 2, 3, 4-5, 6-10, 11+
+
+struct RegionStats {
+    uint64_t cycles = 0;
+    uint64_t calls = 0;
+};
+
+// Beta cutoffs of pvSearch
+struct OrderingStats {
+    uint64_t cutoffs[NB_PICK_STAGE][NB_STAGE_INDEX];
+    uint64_t cutoffsByDepth[NB_CUTOFF_DEPTH][NB_CUTOFF_BUCKET];
+};
+
+struct InstrumentStats {
+    RegionStats regions[NB_INSTRUMENT_REGION];
+    OrderingStats ordering;
+};
+
+// Totals of the current thread, merged into the global ones by flushInstrumentStats()
+extern thread_local InstrumentStats threadInstrumentStats;
+
+class ScopedRegionTimer {
+public:
+    inline ScopedRegionTimer(InstrumentRegion region_): region(region_), start(__builtin_ia32_rdtsc()) { }
+    inline ~ScopedRegionTimer() {
+        RegionStats &stats = threadInstrumentStats.regions[region];
+        stats.cycles += __builtin_ia32_rdtsc() - start;
+        stats.calls++;
+    }
+
+private:
+    InstrumentRegion region;
+    uint64_t start;
+};
+
+// Cutoff by the moveNumber-th move searched at this depth, which was the index-th one of its picker stage
+inline void recordCutoff(PickStage stage, int index, int moveNumber, int depth) {
+    static constexpr int Buckets[12] = {0, 0, 1, 2, 3, 3, 4, 4, 4, 4, 4, 5};
+
+    OrderingStats &stats = threadInstrumentStats.ordering;
+    stats.cutoffs[stage][std::min(index, NB_STAGE_INDEX - 1)]++;
+    stats.cutoffsByDepth[std::clamp(depth, 1, NB_CUTOFF_DEPTH) - 1][Buckets[std::min(moveNumber, 11)]]++;
+}
+
+void flushInstrumentStats();
+void resetInstrumentStats();
+
+// Cycles breakdown of everything flushed since the last report, the global totals are reset
+void printInstrumentReport(size_t nbNodes);
+
+#define INSTRUMENT_CONCAT_(a, b) a##b
+#define INSTRUMENT_CONCAT(a, b) INSTRUMENT_CONCAT_(a, b)
+#define INSTRUMENT_SCOPE(region) ScopedRegionTimer INSTRUMENT_CONCAT(regionTimer, __LINE__)(region)
+
+#else
+
+#define INSTRUMENT_SCOPE(region)
+
+#endif
+
+} /* namespace Belette */
@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include "latency.h"
+
+namespace Belette {
+
+int LatencyHistogram::bucketIndex(TimeUs value) {
+    uint64_t v = std::max<TimeUs>(value, 0);
+    if (v < NbSubBuckets) return int(v);
+
+    int shift = 63 - __builtin_clzll(v) - SubBits;
+    return NbSubBuckets * (shift + 1) + int(v >> shift) - NbSubBuckets;
+}
+
+TimeUs LatencyHistogram::bucketHighest(int index) {
+    if (index < NbSubBuckets) return index;
+
+    int shift = index / NbSubBuckets - 1;
+    TimeUs sub = NbSubBuckets + index % NbSubBuckets;
+    return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(TimeUs value) {
+    buckets[std::min(bucketIndex(value), NbBuckets - 1)]++;
+    minValue = nbValues ? std::min(minValue, value) : value;
+    maxValue = std::max(maxValue, value);
+    sum += value;
+    nbValues++;
+}
+
+void LatencyHistogram::clear() {
+    *this = LatencyHistogram();
+}
+
+TimeUs LatencyHistogram::percentile(double p) const {
+    if (!nbValues) return 0;
+
+    uint64_t rank = std::max<uint64_t>(1, uint64_t(p / 100.0 * nbValues + 0.5));
+    uint64_t seen = 0;
+
+    for (int i = 0; i < NbBuckets; i++) {
+        seen += buckets[i];
+        if (seen >= rank) return std::min(bucketHighest(i), maxValue);
+    }
+
+    return maxValue;
+}
+
+void LatencyTracker::onCommand(TimeUs received, TimeUs processed) {
+    std::lock_guard<std::mutex> lock(mutex);
+    histograms[LATENCY_COMMAND].record(processed - received);
+}
+
+void LatencyTracker::onGo(TimeUs received) {
+    std::lock_guard<std::mutex> lock(mutex);
+    goTime = received;
+    stopTime = 0;
+    waitingFirstInfo = true;
+}
+
+void LatencyTracker::onSearchStart() {
+    std::lock_guard<std::mutex> lock(mutex);
+    histograms[LATENCY_GO_SEARCH_START].record(nowUs() - goTime);
+}
+
+void LatencyTracker::onInfo() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!waitingFirstInfo) return;
+
+    histograms[LATENCY_GO_FIRST_INFO].record(nowUs() - goTime);
+    waitingFirstInfo = false;
+}
+
+void LatencyTracker::onStop(TimeUs received) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (stopTime == 0) stopTime = received;
+}
+
+void LatencyTracker::onBestMove(TimeUs start, TimeUs written) {
+    std::lock_guard<std::mutex> lock(mutex);
+    histograms[LATENCY_BESTMOVE_OUTPUT].record(written - start);
+
+    // Only searches interrupted by the GUI, the other ones stop by themselves
+    if (stopTime != 0) histograms[LATENCY_STOP_BESTMOVE].record(written - stopTime);
+
+    stopTime = 0;
+    waitingFirstInfo = false;
+}
+
+void LatencyTracker::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (LatencyHistogram &histogram : histograms) histogram.clear();
+}
+
+std::string LatencyTracker::report() {
+    static const char *names[NB_LATENCY_MEASURE] = {
+        "command", "go > search", "go > info", "stop > bestmove", "bestmove output"
+    };
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::ostringstream ss;
+
+    ss << "Latency (us)        count      min      p50      p90      p99    p99.9      max      mean" << std::endl;
+
+    for (int i = 0; i < NB_LATENCY_MEASURE; i++) {
+        const LatencyHistogram &h = histograms[i];
+
+        ss << std::left << std::setw(16) << names[i] << std::right
+           << std::setw(9) << h.count() << std::setw(9) << h.min()
+           << std::setw(9) << h.percentile(50) << std::setw(9) << h.percentile(90)
+           << std::setw(9) << h.percentile(99) << std::setw(9) << h.percentile(99.9)
+           << std::setw(9) << h.max() << std::setw(10) << std::fixed << std::setprecision(1) << h.mean() << std::endl;
+    }
+
+    return ss.str();
+}
+
+} /* namespace Belette */
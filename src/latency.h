@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include "utils.h"
+
+namespace Belette {
+
+// Log-linear histogram of durations in microseconds, 16 sub-buckets per power of two (about 6% precision)
+class LatencyHistogram {
+public:
+    void record(TimeUs value);
+    void clear();
+
+    inline uint64_t count() const { return nbValues; }
+    inline TimeUs min() const { return nbValues ? minValue : 0; }
+    inline TimeUs max() const { return maxValue; }
+    inline double mean() const { return nbValues ? double(sum) / nbValues : 0.0; }
+
+    // Highest value of the bucket holding the given percentile, capped by the maximum
+    TimeUs percentile(double p) const;
+
+private:
+    static constexpr int SubBits = 4;
+    static constexpr int NbSubBuckets = 1 << SubBits;
+    static constexpr int NbBuckets = NbSubBuckets * (64 - SubBits);
+
+    static int bucketIndex(TimeUs value);
+    static TimeUs bucketHighest(int index);
+
+    uint64_t buckets[NbBuckets] = {};
+    uint64_t nbValues = 0;
+    TimeUs minValue = 0;
+    TimeUs maxValue = 0;
+    TimeUs sum = 0;
+};
+
+enum LatencyMeasure {
+    LATENCY_COMMAND,            // Receipt to end of processing of the protocol commands
+    LATENCY_GO_SEARCH_START,    // "go" received to search thread running
+    LATENCY_GO_FIRST_INFO,      // "go" received to first "info" written
+    LATENCY_STOP_BESTMOVE,      // "stop" received to "bestmove" written
+    LATENCY_BESTMOVE_OUTPUT,    // Time to write and flush "bestmove"
+    NB_LATENCY_MEASURE
+};
+
+// UCI events of the searches, reported by both the UCI and the search threads
+class LatencyTracker {
+public:
+    void onCommand(TimeUs received, TimeUs processed);
+    void onGo(TimeUs received);
+    void onSearchStart();
+    void onInfo();
+    void onStop(TimeUs received);
+    void onBestMove(TimeUs start, TimeUs written);
+
+    void clear();
+    std::string report();
+
+private:
+    std::mutex mutex;
+    LatencyHistogram histograms[NB_LATENCY_MEASURE];
+    TimeUs goTime = 0;
+    TimeUs stopTime = 0;
+    bool waitingFirstInfo = false;
+};
+
+} /* namespace Belette */
@@ -0,0 +1,289 @@
+
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <thread>
+#include <signal.h>
+#include "match.h"
+#include "dataset.h"
+#include "movegen.h"
+#include "uci.h"
+#include "uciprocess.h"
+
+namespace Belette {
+
+constexpr TimeMs TimeMargin = 50;       // Pipe latency allowed on top of the clock
+constexpr int MaxGamePlies = 1000;
+
+struct GameOutcome {
+    float result;       // White point of view
+    std::string reason;
+    int failed = -1;    // Side whose process has to be restarted
+};
+
+static bool insufficientMaterial(const Position &pos) {
+    return !pos.getPiecesTypeBB(PAWN) && !pos.getPiecesTypeBB(ROOK) && !pos.getPiecesTypeBB(QUEEN)
+        && popcount(pos.getPiecesTypeBB(KNIGHT, BISHOP)) <= 1;
+}
+
+static GameOutcome playGame(UciProcess *engines[NB_SIDE], const std::string &fen, const MatchOptions &options) {
+    auto position = std::make_unique<Position>();
+    Position &pos = *position;
+    pos.setFromFEN(fen);
+
+    for (Side side : {WHITE, BLACK}) {
+        engines[side]->send("ucinewgame");
+        engines[side]->send("isready");
+
+        if (!engines[side]->waitFor("readyok", StartupTimeout))
+            return {side == WHITE ? 0.0f : 1.0f, "disconnect", side};
+    }
+
+    std::string moves;
+    TimeMs clock[NB_SIDE] = {options.time, options.time};
+    int winning[NB_SIDE] = {}, losing[NB_SIDE] = {}, drawish = 0;
+
+    for (int ply = 0; ; ply++) {
+        Side me = pos.getSideToMove();
+        float loss = me == WHITE ? 0.0f : 1.0f;
+
+        MoveList legalMoves;
+        generateLegalMoves(pos, legalMoves);
+
+        if (legalMoves.empty())
+            return pos.inCheck() ? GameOutcome{loss, "checkmate"} : GameOutcome{0.5f, "stalemate"};
+        if (pos.isFiftyMoveDraw())
+            return {0.5f, "fifty moves rule"};
+        if (pos.isRepetitionDraw())
+            return {0.5f, "3-fold repetition"};
+        if (insufficientMaterial(pos))
+            return {0.5f, "insufficient material"};
+        if (ply >= MaxGamePlies)
+            return {0.5f, "maximum game length"};
+
+        UciProcess &engine = *engines[me];
+        std::ostringstream go;
+        TimeMs timeout;
+
+        if (options.nodes > 0) {
+            go << "go nodes " << options.nodes;
+            timeout = 60000;
+        } else if (options.moveTime > 0) {
+            go << "go movetime " << options.moveTime;
+            timeout = options.moveTime + 5000;
+        } else {
+            go << "go wtime " << clock[WHITE] << " btime " << clock[BLACK] << " winc " << options.increment << " binc " << options.increment;
+            timeout = options.nodesTime > 0 ? 60000 : clock[me] + 5000;
+        }
+
+        engine.send("position fen " + fen + (moves.empty() ? "" : " moves" + moves));
+        engine.send(go.str());
+
+        TimeMs start = now();
+        std::string line, token, bestMove;
+        Score score = SCORE_NONE;
+        int64_t nodes = 0;
+
+        while (bestMove.empty() && engine.readLine(line, std::max<TimeMs>(1, start + timeout - now()))) {
+            std::istringstream parser(line);
+            parser >> token;
+
+            if (token == "bestmove") {
+                parser >> bestMove;
+            } else if (token == "info") {
+                while (parser >> token) {
+                    if (token == "nodes") {
+                        parser >> nodes;
+                    } else if (token == "score") {
+                        int value;
+                        parser >> token >> value;
+                        if (token == "cp") score = value;
+                        else if (token == "mate") score = value > 0 ? SCORE_MATE - 2 * value + 1 : -SCORE_MATE - 2 * value;
+                    } else if (token == "pv" || token == "string") {
+                        break;
+                    }
+                }
+            }
+        }
+
+        // Under the virtual clock the engines spend their nodes, as reported by their last info line
+        TimeMs elapsed = options.nodesTime > 0 ? TimeMs(nodes / options.nodesTime) : now() - start;
+
+        if (bestMove.empty())
+            return {loss, engine.isRunning() ? "timeout" : "disconnect", me};
+
+        if (options.nodes == 0 && options.moveTime == 0) {
+            clock[me] -= elapsed;
+            if (clock[me] < -TimeMargin) return {loss, "time forfeit"};
+            clock[me] = std::max<TimeMs>(clock[me], 0) + options.increment;
+        }
+
+        Move move = Uci::parseMove(pos, bestMove);
+        if (move == MOVE_NONE)
+            return {loss, "illegal move " + bestMove};
+
+        // Score adjudication, both engines have to agree
+        if (score != SCORE_NONE) {
+            winning[me] = score >= options.resignScore ? winning[me] + 1 : 0;
+            losing[me] = score <= -options.resignScore ? losing[me] + 1 : 0;
+            drawish = std::abs(score) <= options.drawScore ? drawish + 1 : 0;
+        } else {
+            winning[me] = losing[me] = drawish = 0;
+        }
+
+        if (losing[me] >= options.resignMoves && winning[~me] >= options.resignMoves)
+            return {loss, "adjudication"};
+        if (winning[me] >= options.resignMoves && losing[~me] >= options.resignMoves)
+            return {1.0f - loss, "adjudication"};
+        if (pos.getFullMoves() >= options.drawMoveNumber && drawish >= 2 * options.drawMoves)
+            return {0.5f, "adjudication"};
+
+        pos.doMove(move);
+        moves += " " + bestMove;
+    }
+}
+
+struct MatchStats {
+    int wins = 0;
+    int draws = 0;
+    int losses = 0;
+
+    inline int games() const { return wins + draws + losses; }
+    inline double score() const { return games() ? (wins + 0.5 * draws) / games() : 0.5; }
+
+    inline double variance() const {
+        double s = score();
+        return games() ? (wins * (1 - s) * (1 - s) + draws * (0.5 - s) * (0.5 - s) + losses * s * s) / games() : 0.0;
+    }
+
+    static inline double elo(double score) {
+        score = std::clamp(score, 1e-6, 1 - 1e-6);
+        return -400.0 * std::log10(1.0 / score - 1.0) + 0.0; // No negative zero
+    }
+
+    static inline double expectedScore(double elo) {
+        return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+    }
+
+    // 95% confidence interval
+    inline double eloError() const {
+        if (!games()) return 0.0;
+        double margin = 1.96 * std::sqrt(variance() / games());
+        return (elo(score() + margin) - elo(score() - margin)) / 2;
+    }
+
+    // Generalized SPRT log-likelihood ratio, normal approximation of the trinomial model
+    inline double llr(double elo0, double elo1) const {
+        double var = variance();
+        if (var <= 0) return 0.0;
+
+        double s0 = expectedScore(elo0), s1 = expectedScore(elo1);
+        return 0.5 * games() * (s1 - s0) * (2 * score() - s0 - s1) / var;
+    }
+};
+
+void match(const std::string &engineA, const std::string &engineB, const MatchOptions &options) {
+    const std::string paths[2] = {enginePath(engineA), enginePath(engineB)};
+    std::vector<std::string> engineOptions[2] = {options.engineOptions[0], options.engineOptions[1]};
+    std::vector<std::string> openings = {STARTPOS_FEN};
+
+    if (options.nodesTime > 0) {
+        for (auto &engineOption : engineOptions)
+            engineOption.push_back("nodestime=" + std::to_string(options.nodesTime));
+    }
+
+    if (!options.openings.empty()) {
+        openings = readFens(options.openings);
+
+        if (openings.empty()) {
+            console << "No valid opening found in " << options.openings << std::endl;
+            return;
+        }
+    }
+
+    // A dead engine must not kill the match when we write to its pipe
+    signal(SIGPIPE, SIG_IGN);
+
+    const double lowerBound = std::log(options.beta / (1 - options.alpha));
+    const double upperBound = std::log((1 - options.beta) / options.alpha);
+
+    std::mutex mutex;
+    std::atomic<int> nextGame = 0;
+    std::atomic<bool> stop = false;
+    MatchStats stats;
+    TimeMs start = now();
+
+    auto worker = [&]() {
+        UciProcess engines[2];
+
+        int game;
+        while (!stop && (game = nextGame++) < options.games) {
+            for (int i = 0; i < 2; i++) {
+                if (engines[i].isRunning() || engines[i].start(paths[i], engineOptions[i])) continue;
+
+                std::lock_guard<std::mutex> lock(mutex);
+                console << "Unable to start engine " << paths[i] << std::endl;
+                stop = true;
+                return;
+            }
+
+            // Each opening is played twice, colors reversed
+            bool aIsWhite = game % 2 == 0;
+            const std::string &fen = openings[(game / 2) % openings.size()];
+            UciProcess *players[NB_SIDE] = {&engines[!aIsWhite], &engines[aIsWhite]};
+
+            GameOutcome outcome = playGame(players, fen, options);
+            if (outcome.failed >= 0) players[outcome.failed]->stop(); // Restarted for the next game
+
+            float scoreA = aIsWhite ? outcome.result : 1.0f - outcome.result;
+
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if (scoreA == 1.0f) stats.wins++;
+            else if (scoreA == 0.0f) stats.losses++;
+            else stats.draws++;
+
+            console << "Finished game " << (game + 1) << " (" << players[WHITE]->name << (aIsWhite ? " A" : " B")
+                    << " vs " << players[BLACK]->name << (aIsWhite ? " B" : " A") << "): "
+                    << (outcome.result == 1.0f ? "1-0" : outcome.result == 0.0f ? "0-1" : "1/2-1/2")
+                    << " {" << outcome.reason << "}" << std::endl;
+
+            double llr = stats.llr(options.elo0, options.elo1);
+            TimeMs elapsed = std::max<TimeMs>(1, now() - start);
+
+            console << "info string match games " << stats.games()
+                    << " wins " << stats.wins << " draws " << stats.draws << " losses " << stats.losses
+                    << " elo " << std::fixed << std::setprecision(1) << MatchStats::elo(stats.score()) << " +- " << stats.eloError();
+            if (options.sprt)
+                console << " llr " << std::setprecision(2) << llr << " (" << lowerBound << ", " << upperBound << ")";
+            console << " gpm " << std::setprecision(1) << (60000.0 * stats.games() / elapsed) << std::defaultfloat << std::endl;
+
+            if (options.sprt && (llr <= lowerBound || llr >= upperBound))
+                stop = true;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < std::max(1, options.concurrency); t++)
+        threads.emplace_back(worker);
+
+    for (auto &th : threads) th.join();
+
+    double llr = stats.llr(options.elo0, options.elo1);
+
+    console << std::endl;
+    console << "Games: " << stats.games() << " (+" << stats.wins << " =" << stats.draws << " -" << stats.losses << ")" << std::endl;
+    console << "Score: " << std::fixed << std::setprecision(3) << stats.score() << std::endl;
+    console << "Elo: " << std::setprecision(1) << MatchStats::elo(stats.score()) << " +- " << stats.eloError() << std::endl;
+
+    if (options.sprt) {
+        console << "SPRT [" << options.elo0 << ", " << options.elo1 << "]: llr " << std::setprecision(2) << llr
+                << " (" << lowerBound << ", " << upperBound << ") "
+                << (llr >= upperBound ? "H1 accepted" : llr <= lowerBound ? "H0 accepted" : "inconclusive") << std::endl;
+    }
+
+    console << std::defaultfloat;
+    console << "Time: " << (now() - start) << "ms" << std::endl;
+}
+
+} /* namespace Belette */
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "utils.h"
+
+namespace Belette {
+
+struct MatchOptions {
+    int games = 100;
+    int concurrency = 1;
+
+    // Time control, node count or fixed time per move
+    TimeMs time = 10000;
+    TimeMs increment = 100;
+    size_t nodes = 0;
+    TimeMs moveTime = 0;
+    int64_t nodesTime = 0;                  // Virtual clock of the engines, in nodes per millisecond
+
+    std::string openings;                   // EPD/FEN file, one position per pair of games
+    std::vector<std::string> engineOptions[2]; // "Name=Value", sent with setoption
+
+    // SPRT stops the match as soon as one of the hypotheses is accepted
+    bool sprt = false;
+    double elo0 = 0.0;
+    double elo1 = 5.0;
+    double alpha = 0.05;
+    double beta = 0.05;
+
+    // Score adjudication, both engines have to agree for the given number of moves
+    int resignScore = 1000;
+    int resignMoves = 3;
+    int drawScore = 10;
+    int drawMoves = 8;
+    int drawMoveNumber = 40;
+};
+
+// Play a match between two UCI engines, "self" starts this binary. Results are given from the first engine point of view
+void match(const std::string &engineA, const std::string &engineB, const MatchOptions &options);
+
+} /* namespace Belette */
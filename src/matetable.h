@@ -0,0 +1,62 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "chess.h"
+
+namespace Belette {
+
+constexpr size_t MATE_TABLE_DEFAULT_ENTRIES = 1024*1024;
+
+// Results of the mate search, kept apart from the transposition table: the bounds are pure,
+// a node is either proven to be mated within n attacker moves or refuted, there is no score
+class MateTable {
+public:
+    struct Entry {
+        uint64_t hash = 0;
+        Move move = MOVE_NONE;
+        uint8_t proven = 0;  // Mate proven in n-1 attacker moves, 0 when unknown
+        uint8_t refuted = 0; // No mate in n-1 attacker moves, 0 when unknown
+    }; // 16 Bytes
+
+    MateTable(size_t nbEntries = MATE_TABLE_DEFAULT_ENTRIES) : entries(nbEntries), mask(nbEntries - 1) { }
+
+    inline void clear() { std::fill(entries.begin(), entries.end(), Entry()); }
+    inline size_t memory() const { return entries.size() * sizeof(Entry); }
+
+    // Is the node proven (true) or refuted (false) for n attacker moves
+    inline bool probe(uint64_t hash, int n, bool &mate, Move &move) const {
+        const Entry &entry = entries[hash & mask];
+        if (entry.hash != hash) return false;
+
+        move = entry.move;
+        if (entry.proven && entry.proven - 1 <= n) return mate = true;
+        if (entry.refuted && entry.refuted - 1 >= n) return !(mate = false);
+        return false;
+    }
+
+    // Move of a proven node, MOVE_NONE otherwise
+    inline Move proof(uint64_t hash) const {
+        const Entry &entry = entries[hash & mask];
+        return entry.hash == hash && entry.proven ? entry.move : MOVE_NONE;
+    }
+
+    inline void store(uint64_t hash, int n, bool mate, Move move) {
+        Entry &entry = entries[hash & mask];
+        if (entry.hash != hash) entry = Entry { hash, MOVE_NONE, 0, 0 };
+
+        if (mate) {
+            entry.move = move;
+            entry.proven = uint8_t(n + 1);
+        } else {
+            entry.refuted = std::max(entry.refuted, uint8_t(n + 1));
+        }
+    }
+
+private:
+    std::vector<Entry> entries;
+    size_t mask;
+};
+
+} /* namespace Belette */
@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include "memory.h"
+#include "bitboard.h"
+#include "zobrist.h"
+#include "evaluate.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+namespace Belette {
+
+void MemoryReport::add(const std::string &name, size_t bytes, bool dynamic) {
+    items.push_back({ name, bytes, dynamic });
+}
+
+static std::string formatKiB(size_t bytes) {
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(1) << bytes / 1024.0 << " KiB";
+    return ss.str();
+}
+
+std::string MemoryReport::str() const {
+    std::ostringstream ss;
+    size_t total[2] = {0, 0};
+
+    ss << "Structure                               bytes          size" << std::endl;
+
+    for (bool dynamic : { false, true }) {
+        for (const Item &item : items) {
+            if (item.dynamic != dynamic) continue;
+
+            ss << std::left << std::setw(8) << (dynamic ? "dynamic" : "static") << std::setw(24) << item.name << std::right
+               << std::setw(13) << item.bytes << std::setw(14) << formatKiB(item.bytes) << std::endl;
+            total[dynamic] += item.bytes;
+        }
+    }
+
+    ss << std::left << std::setw(32) << "total static" << std::right << std::setw(13) << total[0] << std::setw(14) << formatKiB(total[0]) << std::endl;
+    ss << std::left << std::setw(32) << "total dynamic" << std::right << std::setw(13) << total[1] << std::setw(14) << formatKiB(total[1]) << std::endl;
+
+    return ss.str();
+}
+
+void addStaticTables(MemoryReport &report) {
+    report.add("rook attacks", sizeof(ROOK_DATA) + sizeof(ROOK_MOVE));
+    report.add("bishop attacks", sizeof(BISHOP_DATA) + sizeof(BISHOP_MOVE));
+    report.add("leaper attacks", sizeof(PAWN_ATTACK) + sizeof(KNIGHT_MOVE) + sizeof(KING_MOVE));
+    report.add("between bitboards", sizeof(BETWEEN_BB));
+    report.add("zobrist keys", sizeof(Zobrist::keys) + sizeof(Zobrist::enpassantKeys) + sizeof(Zobrist::castlingKeys));
+    report.add("psqt", sizeof(PSQT));
+}
+
+bool readProcessMemory(ProcessMemory &mem) {
+    std::ifstream file("/proc/self/status");
+    if (!file) return false;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream is(line);
+        std::string key;
+        size_t kb = 0;
+
+        if (!(is >> key >> kb)) continue;
+
+        if (key == "VmRSS:") mem.rss = kb * 1024;
+        else if (key == "VmHWM:") mem.peakRss = kb * 1024;
+        else if (key == "VmData:") mem.data = kb * 1024;
+        else if (key == "VmStk:") mem.mainStack = kb * 1024;
+    }
+
+    return true;
+}
+
+#ifdef __linux__
+
+void StackWatermark::paint() {
+    pthread_attr_t attr;
+    void *stackAddr;
+    size_t stackSize;
+
+    if (pthread_getattr_np(pthread_self(), &attr) != 0) return;
+    int err = pthread_attr_getstack(&attr, &stackAddr, &stackSize);
+    pthread_attr_destroy(&attr);
+    if (err != 0) return;
+
+    char *bottom = static_cast<char *>(stackAddr);
+    char *sp = static_cast<char *>(__builtin_frame_address(0)) - PaintMargin;
+    char *from = std::max(bottom + PaintMargin, sp - PaintSize);
+    if (sp <= from) return;
+
+    top = reinterpret_cast<uintptr_t>(bottom + stackSize);
+    size = stackSize;
+    low = reinterpret_cast<uint64_t *>((reinterpret_cast<uintptr_t>(from) + 7) & ~uintptr_t(7));
+    high = reinterpret_cast<uint64_t *>(reinterpret_cast<uintptr_t>(sp) & ~uintptr_t(7));
+    painted = (high - low) * sizeof(uint64_t);
+
+    std::fill(low, high, Pattern);
+}
+
+void StackWatermark::measure() {
+    if (low == nullptr) return;
+
+    uint64_t *p = low;
+    while (p < high && *p == Pattern) p++;
+
+    highWater = std::max(highWater, size_t(top - reinterpret_cast<uintptr_t>(p)));
+    low = high = nullptr;
+}
+
+#else
+
+void StackWatermark::paint() { }
+void StackWatermark::measure() { }
+
+#endif
+
+} /* namespace Belette */
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace Belette {
+
+// Sizes of the structures of the engine, static tables are allocated at load time, dynamic ones on demand
+class MemoryReport {
+public:
+    void add(const std::string &name, size_t bytes, bool dynamic = false);
+    std::string str() const;
+
+private:
+    struct Item {
+        std::string name;
+        size_t bytes;
+        bool dynamic;
+    };
+
+    std::vector<Item> items;
+};
+
+// Lookup tables shared by all the engines of the process
+void addStaticTables(MemoryReport &report);
+
+// Process figures from /proc/self/status, in bytes
+struct ProcessMemory {
+    size_t rss = 0;
+    size_t peakRss = 0;
+    size_t data = 0;
+    size_t mainStack = 0; // Grows on demand, so this is the main thread high-water mark
+};
+
+bool readProcessMemory(ProcessMemory &mem);
+
+// Stack high-water mark of a thread: the free part of the stack below the caller is painted with a pattern,
+// the deepest overwritten word gives the maximum stack usage since. Kept across measures
+class StackWatermark {
+public:
+    void paint();   // From the thread to measure, before the work
+    void measure(); // From the same thread, after the work
+
+    inline bool measured() const { return highWater > 0; }
+    inline size_t used() const { return highWater; }
+    inline size_t stackSize() const { return size; }
+    inline size_t paintedSize() const { return painted; }
+
+private:
+    static constexpr size_t PaintSize = 1024 * 1024; // A MAX_PLY deep search needs less than half of it
+    static constexpr size_t PaintMargin = 4096;      // Left for the frames of paint() and memset()
+    static constexpr uint64_t Pattern = 0xA5A5A5A5A5A5A5A5ULL;
+
+    uint64_t *low = nullptr;
+    uint64_t *high = nullptr;
+    uintptr_t top = 0;
+    size_t size = 0;
+    size_t painted = 0;
+    size_t highWater = 0;
+};
+
+} /* namespace Belette */
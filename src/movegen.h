@@ -368,6 +368,7 @@ inline bool enumerateQueenSliderMoves(const Position &pos, Bitboard source, cons
 template<Side Me, MoveGenType MGType = ALL_MOVES, typename Handler>
 inline bool enumerateLegalMoves(const Position &pos, const Handler& handler) {
     assert(pos.nbCheckers() < 3);
+    INSTRUMENT_SCOPE(MGType == TACTICAL_MOVES ? REGION_GEN_TACTICALS : MGType == QUIET_MOVES ? REGION_GEN_QUIETS : REGION_GEN_ALL);
 
     switch(pos.nbCheckers()) {
         case 0:
@@ -408,5 +409,251 @@ inline void generateLegalMoves(const Position &pos, MoveList &moves) {
     });
 }
 
+/**
+ * Pseudo-legal generation, out of check only: the pins are ignored and Position::isPseudoLegalMoveLegal
+ * tells the illegal moves apart, when they are about to be searched. King, castling and en passant moves
+ * are still generated legal. The moves come in the order of the legal generator
+ */
+template<Side Me, MoveGenType MGType = ALL_MOVES, typename Handler>
+inline bool enumeratePseudoLegalPawnMoves(const Position &pos, Bitboard source, const Handler& handler) {
+    constexpr Side Opp = ~Me;
+    constexpr Bitboard Rank3 = (Me == WHITE) ? Rank3BB : Rank6BB;
+    constexpr Bitboard Rank7 = (Me == WHITE) ? Rank7BB : Rank2BB;
+    constexpr Direction Up = (Me == WHITE) ? UP : DOWN;
+    constexpr Direction UpLeft = (Me == WHITE) ? UP_LEFT : DOWN_RIGHT;
+    constexpr Direction UpRight = (Me == WHITE) ? UP_RIGHT : DOWN_LEFT;
+
+    Bitboard emptyBB = pos.getEmptyBB();
+    Bitboard oppPiecesBB = pos.getPiecesBB(Opp);
+    Bitboard pawns = source & ~Rank7;
+
+    // Single & Double Push
+    if constexpr (MGType & QUIET_MOVES) {
+        Bitboard singlePushes = shift<Up>(pawns) & emptyBB;
+        Bitboard doublePushes = shift<Up>(singlePushes & Rank3) & emptyBB;
+
+        bitscan_loop(singlePushes) {
+            Square to = bitscan(singlePushes);
+            CALL_HANDLER(makeMove(to - Up, to));
+        }
+        bitscan_loop(doublePushes) {
+            Square to = bitscan(doublePushes);
+            CALL_HANDLER(makeMove(to - Up - Up, to));
+        }
+    }
+
+    // Normal Capture
+    if constexpr (MGType & TACTICAL_MOVES) {
+        Bitboard capL = shift<UpLeft>(pawns) & oppPiecesBB;
+        Bitboard capR = shift<UpRight>(pawns) & oppPiecesBB;
+
+        bitscan_loop(capL) {
+            Square to = bitscan(capL);
+            CALL_HANDLER(makeMove(to - UpLeft, to));
+        }
+        bitscan_loop(capR) {
+            Square to = bitscan(capR);
+            CALL_HANDLER(makeMove(to - UpRight, to));
+        }
+    }
+
+    // Promotions
+    pawns = source & Rank7;
+    if (pawns) {
+        Bitboard capLPromotions = shift<UpLeft>(pawns) & oppPiecesBB;
+        Bitboard capRPromotions = shift<UpRight>(pawns) & oppPiecesBB;
+        Bitboard quietPromotions = shift<Up>(pawns) & emptyBB;
+
+        bitscan_loop(capLPromotions) {
+            Square to = bitscan(capLPromotions);
+            CALL_ENUMERATOR(enumeratePromotions<Me, MGType>(to - UpLeft, to, handler));
+        }
+        bitscan_loop(capRPromotions) {
+            Square to = bitscan(capRPromotions);
+            CALL_ENUMERATOR(enumeratePromotions<Me, MGType>(to - UpRight, to, handler));
+        }
+        bitscan_loop(quietPromotions) {
+            Square to = bitscan(quietPromotions);
+            CALL_ENUMERATOR(enumeratePromotions<Me, MGType>(to - Up, to, handler));
+        }
+    }
+
+    if constexpr (MGType & TACTICAL_MOVES) {
+        CALL_ENUMERATOR(enumeratePawnEnpassantMoves<Me, false, MGType, Handler>(pos, source, handler));
+    }
+
+    return true;
+}
+
+template<Side Me, PieceType Pt, MoveGenType MGType = ALL_MOVES, typename Handler>
+inline bool enumeratePseudoLegalPieceMoves(const Position &pos, Bitboard source, const Handler& handler) {
+    Bitboard targets = ~pos.getPiecesBB(Me);
+
+    if constexpr (MGType == TACTICAL_MOVES) targets &= pos.getPiecesBB(~Me);
+    if constexpr (MGType == QUIET_MOVES) targets &= ~pos.getPiecesBB(~Me);
+
+    bitscan_loop(source) {
+        Square from = bitscan(source);
+        Bitboard dest = attacks<Pt>(from, pos.getPiecesBB()) & targets;
+
+        bitscan_loop(dest) {
+            Square to = bitscan(dest);
+            CALL_HANDLER(makeMove(from, to));
+        }
+    }
+
+    return true;
+}
+
+template<Side Me, MoveGenType MGType = ALL_MOVES, typename Handler>
+inline bool enumeratePseudoLegalMoves(const Position &pos, const Handler& handler) {
+    assert(!pos.inCheck());
+    INSTRUMENT_SCOPE(MGType == TACTICAL_MOVES ? REGION_GEN_TACTICALS : MGType == QUIET_MOVES ? REGION_GEN_QUIETS : REGION_GEN_ALL);
+
+    // The legal generator gives the moves of the pinned sliders last
+    Bitboard pinned = pos.pinDiag() | pos.pinOrtho();
+    Bitboard diagonals = pos.getPiecesBB(Me, BISHOP, QUEEN), orthogonals = pos.getPiecesBB(Me, ROOK, QUEEN);
+
+    CALL_ENUMERATOR(enumeratePseudoLegalPawnMoves<Me, MGType, Handler>(pos, pos.getPiecesBB(Me, PAWN), handler));
+    CALL_ENUMERATOR(enumeratePseudoLegalPieceMoves<Me, KNIGHT, MGType, Handler>(pos, pos.getPiecesBB(Me, KNIGHT), handler));
+    CALL_ENUMERATOR(enumeratePseudoLegalPieceMoves<Me, BISHOP, MGType, Handler>(pos, diagonals & ~pinned, handler));
+    CALL_ENUMERATOR(enumeratePseudoLegalPieceMoves<Me, BISHOP, MGType, Handler>(pos, diagonals & pinned, handler));
+    CALL_ENUMERATOR(enumeratePseudoLegalPieceMoves<Me, ROOK, MGType, Handler>(pos, orthogonals & ~pinned, handler));
+    CALL_ENUMERATOR(enumeratePseudoLegalPieceMoves<Me, ROOK, MGType, Handler>(pos, orthogonals & pinned, handler));
+    if constexpr (MGType & QUIET_MOVES) CALL_ENUMERATOR(enumerateCastlingMoves<Me, Handler>(pos, handler));
+    CALL_ENUMERATOR(enumerateKingMoves<Me, MGType, Handler>(pos, pos.getKingSquare(Me), handler));
+
+    return true;
+}
+
+/**
+ * Legal tactical moves (the captures, the queen promotions and en passant) coming out in MVV-LVA order:
+ * the capture set of each piece is computed once, then the victims are taken from queen down to pawn and
+ * intersected with the capture sets from pawn up to king. Nothing to score nor to sort, the order is the
+ * one MovePicker::scoreTactical gives, with en passant and the quiet queen promotions last. Among moves
+ * of equal score the order differs from the sorted legal generation
+ */
+template<Side Me, typename Handler>
+inline bool enumerateCapturesByVictim(const Position &pos, const Handler& handler) {
+    constexpr Side Opp = ~Me;
+    constexpr Bitboard Rank7 = (Me == WHITE) ? Rank7BB : Rank2BB;
+    constexpr Bitboard Rank8 = (Me == WHITE) ? Rank8BB : Rank1BB;
+    constexpr Direction Up = (Me == WHITE) ? UP : DOWN;
+    constexpr Direction UpLeft = (Me == WHITE) ? UP_LEFT : DOWN_RIGHT;
+    constexpr Direction UpRight = (Me == WHITE) ? UP_RIGHT : DOWN_LEFT;
+    assert(pos.nbCheckers() < 3);
+    INSTRUMENT_SCOPE(REGION_GEN_TACTICALS);
+
+    Bitboard occupied = pos.getPiecesBB();
+    Bitboard pinDiag = pos.pinDiag(), pinOrtho = pos.pinOrtho();
+
+    // Only the king can move out of a double check, the others have to capture the checker
+    Bitboard targets = pos.getPiecesBB(Opp) & (pos.nbCheckers() == 0 ? ~Bitboard(0) : pos.nbCheckers() == 1 ? pos.checkMask() : 0);
+
+    Bitboard pawns = pos.getPiecesBB(Me, PAWN) & ~pinOrtho;
+    Bitboard capL = (shift<UpLeft>(pawns & ~pinDiag) | (shift<UpLeft>(pawns & pinDiag) & pinDiag)) & targets;
+    Bitboard capR = (shift<UpRight>(pawns & ~pinDiag) | (shift<UpRight>(pawns & pinDiag) & pinDiag)) & targets;
+
+    // Capture sets of the other pieces, from knight up to king
+    Square froms[16];
+    Bitboard captures[16];
+    int nbPieces = 0;
+    Bitboard allCaptures = capL | capR;
+
+    auto add = [&](Square from, Bitboard dest) {
+        if (!dest) return;
+        froms[nbPieces] = from;
+        captures[nbPieces++] = dest;
+        allCaptures |= dest;
+    };
+
+    Bitboard pieces = pos.getPiecesBB(Me, KNIGHT) & ~(pinDiag | pinOrtho);
+    bitscan_loop(pieces) {
+        Square from = bitscan(pieces);
+        add(from, attacks<KNIGHT>(from) & targets);
+    }
+
+    // A pinned slider can only capture along its pin ray
+    auto diagonals = [&](Square from) {
+        return attacks<BISHOP>(from, occupied) & targets & ((pinDiag & from) ? pinDiag : ~Bitboard(0));
+    };
+    auto orthogonals = [&](Square from) {
+        return attacks<ROOK>(from, occupied) & targets & ((pinOrtho & from) ? pinOrtho : ~Bitboard(0));
+    };
+
+    pieces = pos.getPiecesBB(Me, BISHOP) & ~pinOrtho;
+    bitscan_loop(pieces) {
+        Square from = bitscan(pieces);
+        add(from, diagonals(from));
+    }
+
+    pieces = pos.getPiecesBB(Me, ROOK) & ~pinDiag;
+    bitscan_loop(pieces) {
+        Square from = bitscan(pieces);
+        add(from, orthogonals(from));
+    }
+
+    pieces = pos.getPiecesBB(Me, QUEEN);
+    bitscan_loop(pieces) {
+        Square from = bitscan(pieces);
+        add(from, ((pinOrtho & from) ? 0 : diagonals(from)) | ((pinDiag & from) ? 0 : orthogonals(from)));
+    }
+
+    Square kingSquare = pos.getKingSquare(Me);
+    add(kingSquare, attacks<KING>(kingSquare) & pos.getPiecesBB(Opp) & ~pos.checkedSquares());
+
+    for (PieceType victim : {QUEEN, ROOK, BISHOP, KNIGHT, PAWN}) {
+        Bitboard victims = pos.getPiecesBB(Opp, victim) & allCaptures;
+        if (!victims) continue;
+
+        Bitboard left = capL & victims, right = capR & victims;
+        bitscan_loop(left) {
+            Square to = bitscan(left);
+            CALL_HANDLER((Rank8 & to) ? makeMove<PROMOTION>(to - UpLeft, to, QUEEN) : makeMove(to - UpLeft, to));
+        }
+        bitscan_loop(right) {
+            Square to = bitscan(right);
+            CALL_HANDLER((Rank8 & to) ? makeMove<PROMOTION>(to - UpRight, to, QUEEN) : makeMove(to - UpRight, to));
+        }
+
+        for (int i = 0; i < nbPieces; i++) {
+            Bitboard dest = captures[i] & victims;
+            bitscan_loop(dest) {
+                Square to = bitscan(dest);
+                CALL_HANDLER(makeMove(froms[i], to));
+            }
+        }
+    }
+
+    if (pos.nbCheckers() == 2) return true;
+
+    // No victim on the target square, MVV-LVA puts them after the pawn captures
+    pawns = pos.getPiecesBB(Me, PAWN);
+    if (pos.nbCheckers() == 0) {
+        CALL_ENUMERATOR(enumeratePawnEnpassantMoves<Me, false, TACTICAL_MOVES, Handler>(pos, pawns, handler));
+    } else {
+        CALL_ENUMERATOR(enumeratePawnEnpassantMoves<Me, true, TACTICAL_MOVES, Handler>(pos, pawns, handler));
+    }
+
+    pawns &= Rank7 & ~pinDiag;
+    Bitboard promotions = (shift<Up>(pawns & ~pinOrtho) | (shift<Up>(pawns & pinOrtho) & pinOrtho)) & pos.getEmptyBB();
+    if (pos.nbCheckers() == 1) promotions &= pos.checkMask();
+
+    bitscan_loop(promotions) {
+        Square to = bitscan(promotions);
+        CALL_HANDLER(makeMove<PROMOTION>(to - Up, to, QUEEN));
+    }
+
+    return true;
+}
+
+template<typename Handler>
+inline bool enumerateCapturesByVictim(const Position &pos, const Handler& handler) {
+    return pos.getSideToMove() == WHITE 
+            ? enumerateCapturesByVictim<WHITE, Handler>(pos, handler)
+            : enumerateCapturesByVictim<BLACK, Handler>(pos, handler);
+}
+
 } /* namespace Belette */
 
+
@@ -38,6 +38,12 @@ public:
         return history[Me][moveFromTo(m)];
     }
 
+    // Indexed by moveFromTo, for the gathers of the vectorized move scoring
+    template<Side Me>
+    inline const MoveScore* getHistoryTable() const {
+        return history[Me];
+    }
+
     template<Side Me>
     inline void update(const Position& pos, Move bestMove, int ply, int depth, const PartialMoveList& quietMoves) {
         if (!pos.isTactical(bestMove)) {
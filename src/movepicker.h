@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <algorithm>
+#include <immintrin.h>
 #include "fixed_vector.h"
 #include "chess.h"
 #include "position.h"
@@ -28,20 +29,24 @@ struct ScoredMove {
 
 using ScoredMoveList = fixed_vector<ScoredMove, MAX_MOVE, uint8_t>;
 
+constexpr int QuietScoringWidth = 8; // Moves scored together
+
 enum MovePickerType {
     MAIN,
     QUIESCENCE
 };
 
-template<MovePickerType Type, Side Me>
+// BulkScoring scores the quiets 8 at a time with AVX2 once they are all generated, the scalar scoring is
+// kept to compare with (bench movepicker) and for the builds without AVX2. Both give the same scores
+template<MovePickerType Type, Side Me, bool BulkScoring = true>
 class MovePicker {
 public:
-    MovePicker(const Position &pos_, Move ttMove_ = MOVE_NONE)
-    : pos(pos_), ttMove(ttMove_), moveHistory(nullptr), refutations{}
+    MovePicker(const Position &pos_, Move ttMove_ = MOVE_NONE, const TranspositionTable *tt_ = nullptr)
+    : pos(pos_), ttMove(ttMove_), tt(tt_), moveHistory(nullptr), refutations{}
     { }
 
-    MovePicker(const Position &pos_, Move ttMove_, const MoveHistory* moveHistory_, int ply_)
-    : pos(pos_), ttMove(ttMove_), moveHistory(moveHistory_), ply(ply_),
+    MovePicker(const Position &pos_, Move ttMove_, const MoveHistory* moveHistory_, int ply_, const TranspositionTable *tt_ = nullptr)
+    : pos(pos_), ttMove(ttMove_), tt(tt_), moveHistory(moveHistory_), ply(ply_),
       refutations{moveHistory->getKiller<0>(ply), moveHistory->getKiller<1>(ply), moveHistory->getCounter(pos)}
     {
         assert(refutations[0] != refutations[1] || refutations[0] == MOVE_NONE);
@@ -50,29 +55,70 @@ public:
     template<typename Handler>
     inline bool enumerate(const Handler &handler);
 
+#ifdef INSTRUMENT
+    // Stage of the move given to the handler, and its index in the stage
+    inline PickStage stage() const { return currentStage; }
+    inline int stageIndex() const { return currentStageIndex; }
+#endif
+
 private:
     const Position &pos;
     Move ttMove;
+    const TranspositionTable *tt; // Only used for prefetching
 
     const MoveHistory *moveHistory;
     int ply;
     Move refutations[3];
 
+#ifdef INSTRUMENT
+    PickStage currentStage = NB_PICK_STAGE;
+    int currentStageIndex = 0;
+#endif
+
+    inline void prefetch(uint64_t hash) const { if (tt != nullptr) tt->prefetch(hash); }
+
+    // Generator of the tacticals and quiets, selected at compile time. With the pseudo-legal one
+    // the legality is only checked for the moves about to be searched
+    template<MoveGenType MGType, typename Handler>
+    inline void generate(const Handler &handler) const {
+#ifdef PSEUDO_LEGAL_MOVEGEN
+        enumeratePseudoLegalMoves<Me, MGType>(pos, handler);
+#else
+        enumerateLegalMoves<Me, MGType>(pos, handler);
+#endif
+    }
+
+    inline bool isLegal(Move m) const {
+#ifdef PSEUDO_LEGAL_MOVEGEN
+        return pos.isPseudoLegalMoveLegal<Me>(m);
+#else
+        return true;
+#endif
+    }
+
     inline MoveScore scoreEvasion(Move m);
     inline MoveScore scoreTactical(Move m);
     inline MoveScore scoreQuiet(Move m);
+    inline void scoreQuiets(Move *quiets, MoveScore *scores, int nbQuiets);
 };
 
 
-template<MovePickerType Type, Side Me>
+#ifdef INSTRUMENT
+#define PICK_STAGE(s) (currentStageIndex = currentStage == (s) ? currentStageIndex + 1 : 0, currentStage = (s))
+#else
+#define PICK_STAGE(s)
+#endif
+
+template<MovePickerType Type, Side Me, bool BulkScoring>
 template<typename Handler>
-bool MovePicker<Type, Me>::enumerate(const Handler &handler) {
+bool MovePicker<Type, Me, BulkScoring>::enumerate(const Handler &handler) {
     bool skipQuiets = false;
 
-    tt.prefetch(pos.getHashAfter(ttMove));
+    prefetch(pos.getHashAfter(ttMove));
 
     // TT Move
     if (pos.isLegal<Me>(ttMove)) {
+        PICK_STAGE(PICK_TT);
         CALL_HANDLER(ttMove, skipQuiets);
     }
     
@@ -86,7 +132,7 @@ bool MovePicker<Type, Me>::enumerate(const Handler &handler) {
         enumerateLegalMoves<Me, ALL_MOVES>(pos, [&](Move m) {
             if (m == ttMove) return true; // continue;
 
-            tt.prefetch(pos.getHashAfter(m));
+            prefetch(pos.getHashAfter(m));
 
             ScoredMove newMove = ScoredMove(m, scoreEvasion(m));
             moves.insert_sorted(newMove, compare);
@@ -95,6 +141,7 @@ bool MovePicker<Type, Me>::enumerate(const Handler &handler) {
         });
 
         for (auto m : moves) {
+            PICK_STAGE(PICK_EVASION);
             CALL_HANDLER(m.move, skipQuiets);
         }
 
@@ -102,11 +149,11 @@ bool MovePicker<Type, Me>::enumerate(const Handler &handler) {
     }
 
     // Tacticals
-    enumerateLegalMoves<Me, TACTICAL_MOVES>(pos, [&](Move m) {
+    generate<TACTICAL_MOVES>([&](Move m) {
         if (m == ttMove) return true; // continue;
         
         if (moves.size() < 16)
-            tt.prefetch(pos.getHashAfter(m));
+            prefetch(pos.getHashAfter(m));
 
         ScoredMove newMove = ScoredMove(m, scoreTactical(m));
         moves.insert_sorted(newMove, compare);
@@ -115,6 +162,8 @@ bool MovePicker<Type, Me>::enumerate(const Handler &handler) {
     });
 
     for (current = endBadTacticals = moves.begin(); current != moves.end(); current++) {
+        if (!isLegal(current->move)) continue;
+
         if constexpr(Type == MAIN) { // For quiescence prunning of bad captures is done in search
             if (!pos.see(current->move, -50)) { // Allow Bishop takes Knight
                 *endBadTacticals++ = *current;
@@ -122,6 +171,7 @@ bool MovePicker<Type, Me>::enumerate(const Handler &handler) {
             }
         }
 
+        PICK_STAGE(PICK_GOOD_TACTICAL);
         CALL_HANDLER(current->move, skipQuiets);
     }
 
@@ -129,70 +179,88 @@ bool MovePicker<Type, Me>::enumerate(const Handler &handler) {
     if constexpr(Type == QUIESCENCE) return true;
 
     if (moveHistory != nullptr) [[likely]] {
-        tt.prefetch(pos.getHashAfter(refutations[0]));
-        tt.prefetch(pos.getHashAfter(refutations[1]));
-        tt.prefetch(pos.getHashAfter(refutations[2]));
+        prefetch(pos.getHashAfter(refutations[0]));
+        prefetch(pos.getHashAfter(refutations[1]));
+        prefetch(pos.getHashAfter(refutations[2]));
         
         // Killer 1
         if (refutations[0] != ttMove && !pos.isTactical(refutations[0]) && pos.isLegal<Me>(refutations[0])) {
+            PICK_STAGE(PICK_KILLER1);
             CALL_HANDLER(refutations[0], skipQuiets);
         }
 
         // Killer 2
         if (refutations[1] != ttMove && !pos.isTactical(refutations[1]) && pos.isLegal<Me>(refutations[1])) {
+            PICK_STAGE(PICK_KILLER2);
             CALL_HANDLER(refutations[1], skipQuiets);
         }
 
         // Counter
         if (refutations[2] != ttMove && !pos.isTactical(refutations[2]) && refutations[2] != refutations[0] && refutations[2] != refutations[1] && pos.isLegal<Me>(refutations[2])) {
+            PICK_STAGE(PICK_COUNTER);
             CALL_HANDLER(refutations[2], skipQuiets);
         }
     }
 
-    // Quiets
+    // Quiets, generated into a flat buffer to be scored together
     moves.resize(endBadTacticals - moves.begin()); // Keep only bad tacticals
     beginQuiets = endBadTacticals;
 
-    enumerateLegalMoves<Me, QUIET_MOVES>(pos, [&](Move m) {
+    Move quiets[MAX_MOVE + QuietScoringWidth];
+    MoveScore scores[MAX_MOVE + QuietScoringWidth];
+    int nbQuiets = 0;
+
+    generate<QUIET_MOVES>([&](Move m) {
         if (m == ttMove) return true; // continue;
         if (refutations[0] == m || refutations[1] == m || refutations[2] == m) return true; // continue
 
-        if (moves.size() < 48)
-            tt.prefetch(pos.getHashAfter(m));
+        if (moves.size() + nbQuiets < 48)
+            prefetch(pos.getHashAfter(m));
 
-        ScoredMove newMove = ScoredMove(m, scoreQuiet(m));
-        moves.insert_sorted(newMove, compare);
+        quiets[nbQuiets++] = m;
         
         return true;
     });
 
+    scoreQuiets(quiets, scores, nbQuiets);
+
+    for (int i = 0; i < nbQuiets; i++)
+        moves.insert_sorted(ScoredMove(quiets[i], scores[i]), compare);
+
     // Good quiets
     for (current = endBadQuiets = beginQuiets; current != moves.end() && !skipQuiets; current++) {
+        if (!isLegal(current->move)) continue;
+
         if (current->score < -4000) {
             *endBadQuiets++ = *current;
             continue;
         }
 
+        PICK_STAGE(PICK_GOOD_QUIET);
         CALL_HANDLER(current->move, skipQuiets);
     }
 
-    // Bad tacticals
+    // Bad tacticals, the quiets sorted in front of them included
     for (current = moves.begin(); current != endBadTacticals; current++) {
-        tt.prefetch(pos.getHashAfter(current->move));
+        if (!isLegal(current->move)) continue;
+
+        prefetch(pos.getHashAfter(current->move));
+        PICK_STAGE(PICK_BAD_TACTICAL);
         CALL_HANDLER(current->move, skipQuiets);
     }
 
     // Bad quiets
     for (current = beginQuiets; current != endBadQuiets && !skipQuiets; current++) {
-        tt.prefetch(pos.getHashAfter(current->move));
+        prefetch(pos.getHashAfter(current->move));
+        PICK_STAGE(PICK_BAD_QUIET);
         CALL_HANDLER(current->move, skipQuiets);
     }
 
     return true;
 }
 
-template<MovePickerType Type, Side Me>
-MoveScore MovePicker<Type, Me>::scoreEvasion(Move m) {
+template<MovePickerType Type, Side Me, bool BulkScoring>
+MoveScore MovePicker<Type, Me, BulkScoring>::scoreEvasion(Move m) {
     if (pos.isTactical(m)) {
         return scoreTactical(m) + 1000000;
     } else {
@@ -203,13 +271,13 @@ MoveScore MovePicker<Type, Me>::scoreEvasion(Move m) {
     return 0;
 }
 
-template<MovePickerType Type, Side Me>
-MoveScore MovePicker<Type, Me>::scoreTactical(Move m) {
+template<MovePickerType Type, Side Me, bool BulkScoring>
+MoveScore MovePicker<Type, Me, BulkScoring>::scoreTactical(Move m) {
     return PieceValue<MG>(pos.getPieceAt(moveTo(m))) - (int)pieceType(pos.getPieceAt(moveFrom(m))); // MVV-LVA
 }
 
-template<MovePickerType Type, Side Me>
-MoveScore MovePicker<Type, Me>::scoreQuiet(Move m) {
+template<MovePickerType Type, Side Me, bool BulkScoring>
+MoveScore MovePicker<Type, Me, BulkScoring>::scoreQuiet(Move m) {
     assert(movePromotionType(m) != QUEEN);
 
     Square from = moveFrom(m), to = moveTo(m);
@@ -256,5 +324,88 @@ MoveScore MovePicker<Type, Me>::scoreQuiet(Move m) {
     return score;
 }
 
-} /* namespace Belette */
+#ifdef __AVX2__
+// Lanes whose square is set in the bitboard given as its low and high halves: all ones, zero otherwise
+inline __m256i testSquares(__m256i low, __m256i high, __m256i sq) {
+    const __m256i one = _mm256_set1_epi32(1);
 
+    // Shifting by 32 or more gives 0, so only one of the halves holds the bit
+    __m256i bits = _mm256_or_si256(_mm256_srlv_epi32(low, sq), _mm256_srlv_epi32(high, _mm256_sub_epi32(sq, _mm256_set1_epi32(32))));
+    return _mm256_cmpeq_epi32(_mm256_and_si256(bits, one), one);
+}
+
+inline __m256i testSquares(Bitboard b, __m256i sq) {
+    return testSquares(_mm256_set1_epi32(int(uint32_t(b))), _mm256_set1_epi32(int(uint32_t(b >> 32))), sq);
+}
+#endif
+
+// Same scores as scoreQuiet. The buffer has room for QuietScoringWidth - 1 more moves, overwritten as padding
+template<MovePickerType Type, Side Me, bool BulkScoring>
+void MovePicker<Type, Me, BulkScoring>::scoreQuiets(Move *quiets, MoveScore *scores, int nbQuiets) {
+#ifdef __AVX2__
+    if constexpr (BulkScoring) {
+        static_assert(sizeof(Piece) == sizeof(int) && sizeof(MoveScore) == sizeof(int));
+        std::fill(quiets + nbQuiets, quiets + (nbQuiets + QuietScoringWidth - 1) / QuietScoringWidth * QuietScoringWidth, MOVE_NONE);
+
+        // The checking squares of a piece are the squares it attacks from the king square, for the current occupancy
+        Square ksq = pos.getKingSquare(~Me);
+        Bitboard diagonalChecks = attacks<BISHOP>(ksq, pos.getPiecesBB());
+        Bitboard orthogonalChecks = attacks<ROOK>(ksq, pos.getPiecesBB());
+
+        const int *board = reinterpret_cast<const int*>(pos.getPieceTable());
+        const int *threats = reinterpret_cast<const int*>(pos.threatsForTable()); // Low and high halves
+        const int *history = moveHistory != nullptr ? moveHistory->getHistoryTable<Me>() : nullptr;
+
+        const __m256i squareMask = _mm256_set1_epi32(63);
+        const __m256i checkBonus = _mm256_set1_epi32(10000);
+
+        for (int i = 0; i < nbQuiets; i += QuietScoringWidth) {
+            __m256i m = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(quiets + i)));
+            __m256i to = _mm256_and_si256(m, squareMask);
+            __m256i from = _mm256_and_si256(_mm256_srli_epi32(m, 6), squareMask);
+            __m256i pt = _mm256_and_si256(_mm256_i32gather_epi32(board, from, 4), _mm256_set1_epi32(7));
+
+            __m256i score = _mm256_sub_epi32(_mm256_set1_epi32(NB_PIECE_TYPE), pt);
+
+            // Threatened piece moving to a safe square
+            __m256i threatIndex = _mm256_slli_epi32(pt, 1);
+            __m256i threatLow = _mm256_i32gather_epi32(threats, threatIndex, 4);
+            __m256i threatHigh = _mm256_i32gather_epi32(threats, _mm256_add_epi32(threatIndex, _mm256_set1_epi32(1)), 4);
+            __m256i escapes = _mm256_andnot_si256(testSquares(threatLow, threatHigh, to), testSquares(threatLow, threatHigh, from));
+            score = _mm256_add_epi32(score, _mm256_and_si256(escapes, _mm256_i32gather_epi32(PieceThreatenedValue, pt, 4)));
+
+            if (history != nullptr) [[likely]]
+                score = _mm256_add_epi32(score, _mm256_i32gather_epi32(history, _mm256_and_si256(m, _mm256_set1_epi32(0xFFF)), 4));
+
+            // Checks, a bishop also scores the rook and queen checks and a rook the queen ones, as in scoreQuiet
+            __m256i isBishop = _mm256_cmpeq_epi32(pt, _mm256_set1_epi32(BISHOP));
+            __m256i isRook = _mm256_or_si256(isBishop, _mm256_cmpeq_epi32(pt, _mm256_set1_epi32(ROOK)));
+            __m256i isQueen = _mm256_or_si256(isRook, _mm256_cmpeq_epi32(pt, _mm256_set1_epi32(QUEEN)));
+            __m256i diagonal = testSquares(diagonalChecks, to), orthogonal = testSquares(orthogonalChecks, to);
+
+            __m256i checks = _mm256_or_si256(
+                _mm256_or_si256(_mm256_and_si256(_mm256_cmpeq_epi32(pt, _mm256_set1_epi32(PAWN)), testSquares(pawnAttacks(~Me, ksq), to)),
+                                _mm256_and_si256(_mm256_cmpeq_epi32(pt, _mm256_set1_epi32(KNIGHT)), testSquares(attacks<KNIGHT>(ksq), to))),
+                _mm256_and_si256(isBishop, diagonal));
+            score = _mm256_add_epi32(score, _mm256_and_si256(checks, checkBonus));
+            score = _mm256_add_epi32(score, _mm256_and_si256(_mm256_and_si256(isRook, orthogonal), checkBonus));
+            score = _mm256_add_epi32(score, _mm256_and_si256(_mm256_and_si256(isQueen, _mm256_or_si256(diagonal, orthogonal)), checkBonus));
+
+            __m256i promotions = _mm256_cmpeq_epi32(_mm256_and_si256(m, _mm256_set1_epi32(3 << 14)), _mm256_set1_epi32(PROMOTION));
+            score = _mm256_blendv_epi8(score, _mm256_set1_epi32(-10000), promotions);
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(scores + i), score);
+        }
+
+#ifndef NDEBUG
+        for (int i = 0; i < nbQuiets; i++) assert(scores[i] == scoreQuiet(quiets[i]));
+#endif
+        return;
+    }
+#endif
+
+    for (int i = 0; i < nbQuiets; i++)
+        scores[i] = scoreQuiet(quiets[i]);
+}
+
+} /* namespace Belette */
@@ -0,0 +1,14 @@
+#include "params.h"
+
+namespace Belette {
+
+#ifdef TUNE
+
+std::vector<TunableParam> &tunableParams() {
+    static std::vector<TunableParam> params;
+    return params;
+}
+
+#endif
+
+} /* namespace Belette */
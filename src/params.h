@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+
+namespace Belette {
+
+#ifdef TUNE
+
+// Search parameter exposed as a UCI spin option for SPSA tuning
+struct TunableParam {
+    const char *name;
+    int &value;
+    int defaultValue;
+    int min;
+    int max;
+    int step; // SPSA perturbation at the end of the tuning
+};
+
+std::vector<TunableParam> &tunableParams();
+
+struct TunableParamRegistrar {
+    TunableParamRegistrar(const char *name, int &value, int min, int max, int step) {
+        tunableParams().push_back({name, value, value, min, max, step});
+    }
+};
+
+#define SEARCH_PARAM(name, value, min, max, step) \
+    inline int name = value; \
+    inline TunableParamRegistrar name##Registrar(#name, name, min, max, step)
+
+#else
+
+#define SEARCH_PARAM(name, value, min, max, step) constexpr int name = value
+
+#endif
+
+// Name, value, min, max, step
+SEARCH_PARAM(AspirationMinDepth,     5,   2,  10,  1);
+SEARCH_PARAM(AspirationDelta,       16,   4,  64,  4);
+SEARCH_PARAM(AspirationScoreDiv,   100,  25, 400, 25);
+
+SEARCH_PARAM(RfpMaxDepth,            4,   1,  10,  1);
+SEARCH_PARAM(RfpMargin,            100,  30, 250, 15);
+
+SEARCH_PARAM(RazorMaxDepth,          2,   1,   6,  1);
+SEARCH_PARAM(RazorMargin,          400, 150, 800, 40);
+
+SEARCH_PARAM(NmpBase,                4,   2,   6,  1);
+SEARCH_PARAM(NmpDepthDiv,            4,   2,   8,  1);
+
+SEARCH_PARAM(LmpBase,                3,   1,  10,  1);
+
+SEARCH_PARAM(SeeMaxDepth,            8,   4,  12,  1);
+SEARCH_PARAM(SeeTacticalMargin,    100,  30, 200, 15);
+SEARCH_PARAM(SeeQuietMargin,        60,  20, 150, 10);
+
+// In hundredths, the LMR table has to be recomputed by Engine::init() when they change
+SEARCH_PARAM(LmrBase,               25, -50, 150, 10);
+SEARCH_PARAM(LmrScale,              46,  20,  80,  4);
+
+} /* namespace Belette */
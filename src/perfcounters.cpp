@@ -0,0 +1,96 @@
+#include "perfcounters.h"
+
+#ifdef __linux__
+#include <cstring>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+namespace Belette {
+
+const char *PerfCounters::name(PerfEvent event) {
+    static const char *names[NB_PERF_EVENT] = {
+        "cycles", "instructions", "branch-misses", "l1d-misses", "llc-misses", "dtlb-misses"
+    };
+    return names[event];
+}
+
+#ifdef __linux__
+
+static constexpr uint64_t cacheConfig(uint64_t cache) {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+bool PerfCounters::open() {
+    static const struct { uint32_t type; uint64_t config; } events[NB_PERF_EVENT] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+        { PERF_TYPE_HW_CACHE, cacheConfig(PERF_COUNT_HW_CACHE_L1D) },
+        { PERF_TYPE_HW_CACHE, cacheConfig(PERF_COUNT_HW_CACHE_LL) },
+        { PERF_TYPE_HW_CACHE, cacheConfig(PERF_COUNT_HW_CACHE_DTLB) },
+    };
+
+    close();
+    bool opened = false;
+
+    for (int i = 0; i < NB_PERF_EVENT; i++) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = events[i].type;
+        attr.config = events[i].config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1; // Allowed with the default perf_event_paranoid level
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        fds[i] = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        opened |= fds[i] >= 0;
+    }
+
+    return opened;
+}
+
+void PerfCounters::close() {
+    for (int &fd : fds) {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+}
+
+void PerfCounters::start() {
+    for (int fd : fds) {
+        if (fd < 0) continue;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+void PerfCounters::stop() {
+    for (int i = 0; i < NB_PERF_EVENT; i++) {
+        values[i] = 0;
+        if (fds[i] < 0) continue;
+
+        ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+        // Value, time enabled, time running. Scaled when the counters had to be multiplexed
+        uint64_t data[3];
+        if (read(fds[i], data, sizeof(data)) != sizeof(data) || data[2] == 0) continue;
+
+        values[i] = data[2] < data[1] ? uint64_t(double(data[0]) * data[1] / data[2]) : data[0];
+    }
+}
+
+#else
+
+bool PerfCounters::open() { return false; }
+void PerfCounters::close() { }
+void PerfCounters::start() { }
+void PerfCounters::stop() { }
+
+#endif
+
+} /* namespace Belette */
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Belette {
+
+enum PerfEvent {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_BRANCH_MISSES,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_DTLB_MISSES,
+    NB_PERF_EVENT
+};
+
+// Hardware performance counters of the calling thread (Linux perf_event_open).
+// Each counter is opened on its own, so the ones refused by the kernel or missing on the CPU are simply unavailable
+class PerfCounters {
+public:
+    PerfCounters() = default;
+    PerfCounters(const PerfCounters &) = delete;
+    ~PerfCounters() { close(); }
+    PerfCounters& operator=(const PerfCounters &) = delete;
+
+    // False if no counter at all could be opened
+    bool open();
+    void close();
+
+    void start();
+    void stop();
+
+    inline bool available(PerfEvent event) const { return fds[event] >= 0; }
+    inline uint64_t value(PerfEvent event) const { return values[event]; }
+
+    static const char *name(PerfEvent event);
+
+private:
+    int fds[NB_PERF_EVENT] = {-1, -1, -1, -1, -1, -1};
+    uint64_t values[NB_PERF_EVENT] = {};
+};
+
+} /* namespace Belette */
@@ -0,0 +1,231 @@
+
+#include <cstring>
+#include "pgn.h"
+#include "movegen.h"
+
+namespace Belette {
+
+static inline bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static inline PieceType parsePieceType(char c) {
+    switch (c) {
+        case 'N': case 'n': return KNIGHT;
+        case 'B': case 'b': return BISHOP;
+        case 'R': case 'r': return ROOK;
+        case 'Q': case 'q': return QUEEN;
+        case 'K': case 'k': return KING;
+        default: return NO_PIECE_TYPE;
+    }
+}
+
+static inline bool parseResult(std::string_view token, float &result) {
+    if (token == "1-0") result = 1.0f;
+    else if (token == "0-1") result = 0.0f;
+    else if (token == "1/2-1/2") result = 0.5f;
+    else if (token == "*") result = RESULT_UNKNOWN;
+    else return false;
+
+    return true;
+}
+
+Move parseSan(const Position &pos, std::string_view san) {
+    // Check, mate & annotation suffixes
+    while (!san.empty() && std::strchr("+#!?", san.back())) san.remove_suffix(1);
+
+    if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0") {
+        File kingTo = san.size() == 3 ? FILE_G : FILE_C;
+        Move move = MOVE_NONE;
+
+        enumerateLegalMoves(pos, [&](Move m) {
+            if (moveType(m) != CASTLING || fileOf(moveTo(m)) != kingTo) return true;
+            move = m;
+            return false;
+        });
+
+        return move;
+    }
+
+    if (san.size() < 2) return MOVE_NONE;
+
+    PieceType pt = PAWN, promotion = NO_PIECE_TYPE;
+    size_t begin = 0, end = san.size();
+
+    if (san[0] >= 'A' && san[0] <= 'Z') {
+        pt = parsePieceType(san[0]);
+        if (pt == NO_PIECE_TYPE) return MOVE_NONE;
+        begin++;
+    } else if (!std::isdigit(san[end - 1])) {
+        // Pawn promotion, with or without '='
+        promotion = parsePieceType(san[end - 1]);
+        if (promotion == NO_PIECE_TYPE || promotion == KING) return MOVE_NONE;
+        end--;
+        if (end > 0 && san[end - 1] == '=') end--;
+    }
+
+    if (end < begin + 2) return MOVE_NONE;
+
+    char toFile = san[end - 2], toRank = san[end - 1];
+    if (toFile < 'a' || toFile > 'h' || toRank < '1' || toRank > '8') return MOVE_NONE;
+    Square to = square(File(toFile - 'a'), Rank(toRank - '1'));
+
+    // Disambiguation, capture marks are ignored
+    int fromFile = -1, fromRank = -1;
+    for (size_t i = begin; i < end - 2; i++) {
+        char c = san[i];
+        if (c >= 'a' && c <= 'h') fromFile = c - 'a';
+        else if (c >= '1' && c <= '8') fromRank = c - '1';
+        else if (c != 'x' && c != ':' && c != '-') return MOVE_NONE;
+    }
+
+    Move move = MOVE_NONE;
+
+    enumerateLegalMoves(pos, [&](Move m) {
+        Square from = moveFrom(m);
+
+        if (moveTo(m) != to || moveType(m) == CASTLING) return true;
+        if (pieceType(pos.getPieceAt(from)) != pt) return true;
+        if (fromFile >= 0 && fileOf(from) != fromFile) return true;
+        if (fromRank >= 0 && rankOf(from) != fromRank) return true;
+        if ((moveType(m) == PROMOTION ? movePromotionType(m) : NO_PIECE_TYPE) != promotion) return true;
+
+        move = m;
+        return false;
+    });
+
+    return move;
+}
+
+static void parseTag(std::string_view line, PgnGame &game) {
+    size_t nameEnd = line.find_first_of(" \t");
+    size_t valueBegin = line.find('"');
+    size_t valueEnd = line.rfind('"');
+    if (nameEnd == std::string_view::npos || valueBegin == valueEnd) return;
+
+    std::string_view name = line.substr(1, nameEnd - 1);
+    std::string_view value = line.substr(valueBegin + 1, valueEnd - valueBegin - 1);
+
+    if (name == "FEN") {
+        game.fen = value;
+    } else if (name == "Result") {
+        parseResult(value, game.result);
+    }
+}
+
+bool parsePgnGame(std::string_view text, size_t &offset, PgnGame &game) {
+    game.fen.clear();
+    game.moves.clear();
+    game.result = RESULT_UNKNOWN;
+
+    bool inMoves = false, found = false;
+    int variationDepth = 0;
+    size_t i = offset;
+
+    while (i < text.size()) {
+        char c = text[i];
+        bool lineStart = i == 0 || text[i - 1] == '\n';
+
+        if (isSpace(c)) {
+            i++;
+        } else if (c == '[' && lineStart && variationDepth == 0) {
+            // A tag after the movetext is the next game, which has no termination marker
+            if (inMoves) break;
+
+            size_t eol = std::min(text.find('\n', i), text.size());
+            parseTag(text.substr(i, eol - i), game);
+            found = true;
+            i = eol;
+        } else if (c == '%' && lineStart) {
+            i = std::min(text.find('\n', i), text.size());
+        } else if (c == ';') {
+            i = std::min(text.find('\n', i), text.size());
+        } else if (c == '{') {
+            i = std::min(text.find('}', i), text.size()) + 1;
+        } else if (c == '(') {
+            variationDepth++;
+            i++;
+        } else if (c == ')') {
+            variationDepth = std::max(0, variationDepth - 1);
+            i++;
+        } else {
+            size_t tokenEnd = i;
+            while (tokenEnd < text.size() && !isSpace(text[tokenEnd]) && !std::strchr("{}();", text[tokenEnd])) tokenEnd++;
+
+            std::string_view token = text.substr(i, tokenEnd - i);
+            i = tokenEnd;
+            inMoves = found = true;
+
+            if (variationDepth > 0 || token[0] == '$') continue;
+
+            float result;
+            if (parseResult(token, result)) {
+                if (game.result == RESULT_UNKNOWN) game.result = result;
+                break;
+            }
+
+            // Move numbers ("12.", "12...", "12.e4"), but not castling written with zeros
+            size_t moveBegin = token.starts_with("0-0") ? 0 : token.find_first_not_of("0123456789.");
+            if (moveBegin == std::string_view::npos) continue;
+            if (moveBegin > 0 && token[moveBegin - 1] != '.') continue;
+
+            game.moves.emplace_back(token.substr(moveBegin));
+        }
+    }
+
+    offset = i;
+
+    return found;
+}
+
+bool PgnReader::open(const std::string &filename) {
+    // The reader may still hold the previous file, at its end
+    file.close();
+    file.clear();
+    file.open(filename, std::ios::binary);
+    pending.clear();
+
+    return !!file;
+}
+
+// Offset of the last game beginning in the text, if any. A game begins with a tag line that does not follow another tag line
+static size_t lastGameStart(const std::string &text) {
+    size_t pos = text.size();
+
+    while (pos > 0 && (pos = text.rfind("\n[", pos - 1)) != std::string::npos) {
+        size_t prevEnd = text.find_last_not_of(" \t\r\n", pos);
+        if (prevEnd == std::string::npos) return std::string::npos;
+
+        size_t prevBegin = text.rfind('\n', prevEnd);
+        prevBegin = prevBegin == std::string::npos ? 0 : prevBegin + 1;
+
+        if (text[prevBegin] != '[') return pos + 1;
+    }
+
+    return std::string::npos;
+}
+
+bool PgnReader::nextChunk(std::string &chunk, size_t size) {
+    constexpr size_t BlockSize = 1 << 20;
+
+    size_t cut = std::string::npos;
+
+    while (file) {
+        if (pending.size() >= size && (cut = lastGameStart(pending)) != std::string::npos)
+            break;
+
+        size_t n = pending.size();
+        pending.resize(n + BlockSize);
+        file.read(pending.data() + n, BlockSize);
+        pending.resize(n + file.gcount());
+    }
+
+    if (cut == std::string::npos) cut = pending.size();
+
+    chunk.assign(pending, 0, cut);
+    pending.erase(0, cut);
+
+    return !chunk.empty();
+}
+
+} /* namespace Belette */
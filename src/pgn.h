@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include "position.h"
+
+namespace Belette {
+
+constexpr float RESULT_UNKNOWN = -1.0f;
+
+struct PgnGame {
+    std::string fen;                // From the FEN tag, empty for the standard start position
+    std::vector<std::string> moves; // SAN moves of the main line
+    float result = RESULT_UNKNOWN;  // White point of view
+};
+
+// Parse a SAN move ("e4", "Nbd7", "exd8=Q+", "O-O", ...), MOVE_NONE if it is malformed or illegal
+Move parseSan(const Position &pos, std::string_view san);
+
+// Parse the game starting at offset, which is moved past it. Comments, NAGs & variations are skipped
+bool parsePgnGame(std::string_view text, size_t &offset, PgnGame &game);
+
+// Read a PGN file by chunks made of whole games
+class PgnReader {
+public:
+    bool open(const std::string &filename);
+
+    // Read at least `size` bytes (unless the file ends), cut on a game boundary
+    bool nextChunk(std::string &chunk, size_t size);
+
+private:
+    std::ifstream file;
+    std::string pending;
+};
+
+} /* namespace Belette */
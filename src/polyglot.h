@@ -0,0 +1,27 @@
+#pragma once
+
+#include "position.h"
+
+namespace Belette {
+
+// Polyglot opening book format (http://hgm.nubati.net/book_format.html)
+namespace Polyglot {
+    struct Entry {
+        uint64_t key;
+        uint16_t move;
+        uint16_t weight;
+        uint32_t learn;
+    };
+
+    constexpr size_t EntrySize = 16; // On disk, big endian
+
+    extern const uint64_t Random64[781];
+
+    uint64_t hash(const Position &pos);
+    uint16_t encodeMove(Move m);
+
+    // Serialize an entry to its 16 bytes big endian representation
+    void writeEntry(char *buffer, const Entry &entry);
+}
+
+} /* namespace Belette */
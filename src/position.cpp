@@ -1,5 +1,6 @@
 #include <sstream>
 #include <cstring>
+#include <cstddef>
 #include "position.h"
 #include "uci.h"
 #include "zobrist.h"
@@ -21,12 +22,13 @@ Position::Position() {
 }
 
 Position::Position(const Position &other) {
-    std::memcpy(this, &other, sizeof(Position));
-    this->state = this->history + (other.state - other.history);
+    *this = other;
 }
 
+// Only copy the used part of the history, a fresh position is much smaller than MAX_HISTORY states
 Position& Position::operator=(const Position &other) {
-    std::memcpy(this, &other, sizeof(Position));
+    std::memcpy(this, &other, offsetof(Position, history));
+    std::memcpy(this->history, other.history, (other.state - other.history + 1) * sizeof(State));
     this->state = this->history + (other.state - other.history);
 
     return *this;
@@ -84,7 +86,7 @@ std::string Position::fen() const {
     if (canCastle(WHITE_KING_SIDE)) ss << 'K';
     if (canCastle(WHITE_QUEEN_SIDE)) ss << 'Q';
     if (canCastle(BLACK_KING_SIDE)) ss << 'k';
-    if (canCastle(BLACK_KING_SIDE)) ss << 'q';
+    if (canCastle(BLACK_QUEEN_SIDE)) ss << 'q';
     if (!canCastle(ANY_CASTLING)) ss << '-';
 
     ss << (getEpSquare() == SQ_NONE ? " - " : " " + Uci::formatSquare(getEpSquare()) + " ");
@@ -585,6 +587,8 @@ inline void Position::updateBitboards() {
 
 template<Side Me>
 inline void Position::updateBitboards() {
+    INSTRUMENT_SCOPE(REGION_UPDATE_BITBOARDS);
+
     updateThreatenedSquares<Me>();
     updateCheckers<Me>();
     checkers() ? updatePinsAndCheckMask<Me, true>() : updatePinsAndCheckMask<Me, false>();
@@ -594,7 +598,8 @@ template<Side Me>
 inline void Position::updateThreatenedSquares() {
     constexpr Side Opp = ~Me;
 
-    assert(state->threatsFor[PAWN] == EmptyBB);
+    // Pawns are never threatened by a less valuable piece. Set explicitly since states are not zeroed
+    state->threatsFor[PAWN] = EmptyBB;
 
     // Pawns
     Bitboard threatened = pawnAttacks<Opp>(getPiecesBB(Opp, PAWN));
@@ -704,6 +709,8 @@ uint64_t Position::computeHash() const {
 
 // Static exchange evaluation. Algorithm from stockfish
 bool Position::see(Move move, int threshold) const {
+    INSTRUMENT_SCOPE(REGION_SEE);
+
     assert(isValidMove(move));
     assert(getSideToMove() == side(getPieceAt(moveFrom(move))));
 
@@ -6,6 +6,7 @@
 #include "chess.h"
 #include "bitboard.h"
 #include "zobrist.h"
+#include "instrument.h"
 
 #define STARTPOS_FEN "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
 #define KIWIPETE_FEN "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"
@@ -48,7 +49,7 @@ public:
     inline void doMove(Move m) { getSideToMove() == WHITE ? doMove<WHITE>(m) : doMove<BLACK>(m); }
     template<Side Me> inline void doMove(Move m);
 
-    inline void undoMove(Move m) { getSideToMove() == WHITE ? undoMove<WHITE>(m) : undoMove<BLACK>(m); }
+    inline void undoMove(Move m) { getSideToMove() == WHITE ? undoMove<BLACK>(m) : undoMove<WHITE>(m); }
     template<Side Me> inline void undoMove(Move m);
 
     template<Side Me> void doNullMove();
@@ -62,6 +63,7 @@ public:
     inline int getFullMoves() const { return 1 + (getHalfMoves() - (sideToMove == BLACK)) / 2; }
     inline Square getEpSquare() const { return state->epSquare; }
     inline Piece getPieceAt(Square sq) const { return pieces[sq]; }
+    inline const Piece* getPieceTable() const { return pieces; } // For the gathers of the vectorized move scoring
     inline bool isEmpty(Square sq) const { return getPieceAt(sq) == NO_PIECE; }
     inline bool isEmpty(Bitboard b) const { return !(b & getPiecesBB()); }
     inline bool canCastle(CastlingRight cr) const { return state->castlingRights & cr; }
@@ -97,6 +99,7 @@ public:
     inline Bitboard getAttackers(Square sq, Bitboard occupied) const;
 
     inline Bitboard threatsFor(PieceType pt) const { return state->threatsFor[pt]; }
+    inline const Bitboard* threatsForTable() const { return state->threatsFor; }
     inline Bitboard checkedSquares() const { return threatsFor(KING); }
     inline Bitboard checkers() const { return state->checkers; }
     inline Bitboard nbCheckers() const { return popcount(state->checkers); }
@@ -122,6 +125,11 @@ public:
 
     template<Side Me> bool isLegal(Move m) const;
     inline bool isLegal(Move m) const { return getSideToMove() == WHITE ? isLegal<WHITE>(m) : isLegal<BLACK>(m); };
+    // Move of the pseudo-legal generator, out of check: only a pinned piece leaving its pin ray is illegal
+    template<Side Me> inline bool isPseudoLegalMoveLegal(Move m) const {
+        Square from = moveFrom(m), to = moveTo(m), ksq = getKingSquare(Me);
+        return !((pinDiag() | pinOrtho()) & from) || (betweenBB(ksq, to) & from) || (betweenBB(ksq, from) & to);
+    }
     inline bool isCapture(Move m) const { return getPieceAt(moveTo(m)) != NO_PIECE || moveType(m) == EN_PASSANT; }
     inline bool isTactical(Move m) const { return isCapture(m) || (moveType(m) == PROMOTION && movePromotionType(m) == QUEEN); }
 
@@ -219,6 +227,8 @@ inline bool Position::isRepetitionDraw() const {
 
 template<Side Me>
 inline void Position::doMove(Move m) {
+    INSTRUMENT_SCOPE(REGION_DO_MOVE);
+
     switch(moveType(m)) {
         case NORMAL:     doMove<Me, NORMAL>(m); return;
         case CASTLING:   doMove<Me, CASTLING>(m); return;
@@ -229,6 +239,8 @@ inline void Position::doMove(Move m) {
 
 template<Side Me>
 inline void Position::undoMove(Move m) {
+    INSTRUMENT_SCOPE(REGION_UNDO_MOVE);
+
     switch(moveType(m)) {
         case NORMAL:     undoMove<Me, NORMAL>(m); return;
         case CASTLING:   undoMove<Me, CASTLING>(m); return;
@@ -0,0 +1,154 @@
+
+#include <vector>
+#include <thread>
+#include <memory>
+#include "quietize.h"
+#include "dataset.h"
+#include "engine.h"
+#include "evaluate.h"
+#include "uci.h"
+#include "utils.h"
+
+namespace Belette {
+
+class QuietizeEngine : public Engine {
+protected:
+    virtual void onSearchProgress(const SearchEvent &event) { }
+    virtual void onSearchFinish(const SearchEvent &event) { }
+};
+
+struct QuietizeStats {
+    size_t kept = 0;
+    size_t invalid = 0;
+    size_t inCheck = 0;
+    size_t swing = 0;
+
+    inline QuietizeStats& operator+=(const QuietizeStats &other) {
+        kept += other.kept;
+        invalid += other.invalid;
+        inCheck += other.inCheck;
+        swing += other.swing;
+        return *this;
+    }
+};
+
+static void quietizeChunk(QuietizeEngine &engine, const DataEntry *begin, const DataEntry *end, const QuietizeOptions &options,
+                          bool binary, std::string &output, QuietizeStats &stats)
+{
+    Position &pos = engine.position();
+    MoveList pv;
+
+    output.clear();
+
+    for (const DataEntry *entry = begin; entry != end; entry++) {
+        if (!pos.setFromFEN(entry->fen)) {
+            stats.invalid++;
+            continue;
+        }
+
+        if (pos.inCheck()) {
+            stats.inCheck++;
+            continue;
+        }
+
+        Score eval = evaluate(pos);
+        Score score = engine.quiescence(pv);
+
+        if (std::abs(score) >= SCORE_MATE_MAX_PLY || std::abs(score - eval) > options.maxSwing) {
+            stats.swing++;
+            continue;
+        }
+
+        // Follow the PV to the quiet leaf
+        for (Move m : pv) pos.doMove(m);
+
+        if (pos.inCheck()) {
+            stats.inCheck++;
+            continue;
+        }
+
+        encodeEntry(output, pos, *entry, binary);
+        stats.kept++;
+    }
+}
+
+void quietize(const std::string &input, const std::string &output, const QuietizeOptions &options) {
+    constexpr size_t ChunkSize = 4096; // Per thread
+
+    DatasetReader reader;
+    DatasetWriter writer;
+    int nbThreads = std::max(1, options.threads);
+
+    if (!reader.open(input)) {
+        console << "Unable to open dataset " << input << std::endl;
+        return;
+    }
+
+    if (!writer.open(output, options.binary || reader.isBinary())) {
+        console << "Unable to open output file " << output << std::endl;
+        return;
+    }
+
+    std::vector<std::unique_ptr<QuietizeEngine>> engines;
+    for (int t = 0; t < nbThreads; t++) {
+        engines.push_back(std::make_unique<QuietizeEngine>());
+        engines.back()->setHashSize(options.hashSize * 1024 * 1024);
+    }
+
+    auto readChunk = [&](std::vector<DataEntry> &chunk) {
+        chunk.resize(ChunkSize * nbThreads);
+        size_t n = 0;
+        while (n < chunk.size() && reader.next(chunk[n])) n++;
+        chunk.resize(n);
+    };
+
+    std::vector<DataEntry> current, next;
+    std::vector<std::string> buffers(nbThreads);
+    std::vector<QuietizeStats> stats(nbThreads);
+    QuietizeStats total;
+    size_t nbRead = 0;
+    TimeMs start = now();
+
+    readChunk(current);
+
+    // Workers resolve the current chunk while the next one is read
+    while (!current.empty()) {
+        std::vector<std::thread> threads;
+        size_t slice = (current.size() + nbThreads - 1) / nbThreads;
+
+        for (int t = 0; t < nbThreads; t++) {
+            stats[t] = QuietizeStats();
+            const DataEntry *begin = current.data() + std::min(current.size(), t * slice);
+            const DataEntry *end = current.data() + std::min(current.size(), (t + 1) * slice);
+
+            threads.emplace_back([&, t, begin, end] {
+                quietizeChunk(*engines[t], begin, end, options, writer.isBinary(), buffers[t], stats[t]);
+            });
+        }
+
+        readChunk(next);
+
+        for (auto &th : threads) th.join();
+
+        for (int t = 0; t < nbThreads; t++) {
+            writer.write(buffers[t], stats[t].kept);
+            total += stats[t];
+        }
+
+        nbRead += current.size();
+        std::swap(current, next);
+
+        TimeMs elapsed = std::max<TimeMs>(1, now() - start);
+        console << "info string quietize positions " << nbRead << " pps " << (1000 * nbRead / elapsed) << std::endl;
+    }
+
+    TimeMs elapsed = std::max<TimeMs>(1, now() - start);
+    console << "Positions: " << nbRead << std::endl;
+    console << "Kept: " << total.kept << std::endl;
+    console << "Dropped (in check): " << total.inCheck << std::endl;
+    console << "Dropped (eval swing): " << total.swing << std::endl;
+    console << "Dropped (invalid): " << total.invalid << std::endl;
+    console << "Time: " << elapsed << "ms (" << (1000 * nbRead / elapsed) << " positions/s)" << std::endl;
+}
+
+} /* namespace Belette */
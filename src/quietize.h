@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+
+namespace Belette {
+
+struct QuietizeOptions {
+    int threads = 1;
+    int maxSwing = 200;     // Drop positions where qsearch moves the static eval by more than this
+    size_t hashSize = 4;    // Per thread, in MB
+    bool binary = false;    // Write the binary format even if the input is EPD
+};
+
+// Resolve each position of the dataset to the leaf of its quiescence PV, keeping the original labels
+void quietize(const std::string &input, const std::string &output, const QuietizeOptions &options);
+
+} /* namespace Belette */
@@ -0,0 +1,171 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <thread>
+#include "resources.h"
+#include "tt.h"
+
+#ifdef __linux__
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+namespace Belette {
+
+constexpr size_t MB = 1024 * 1024;
+constexpr size_t MaxHashSize = 1048576; // MB, maximum of the Hash option
+constexpr int HashMemoryDiv = 2;        // Share of the memory left for the transposition table
+
+size_t SystemResources::availableMemory() const {
+    if (memoryLimit == 0) return physicalMemory;
+    if (physicalMemory == 0) return memoryLimit;
+    return std::min(memoryLimit, physicalMemory);
+}
+
+int SystemResources::availableCpus() const {
+    int cpus = affinityCpus > 0 ? affinityCpus : hardwareCpus;
+
+    // A fractional quota is throttled, so it is rounded down
+    if (cpuQuota > 0) cpus = std::min(cpus, int(cpuQuota));
+
+    return std::max(1, cpus);
+}
+
+std::string SystemResources::str() const {
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(1)
+       << "memory " << physicalMemory / MB << " MB limit ";
+    if (memoryLimit > 0) ss << memoryLimit / MB << " MB"; else ss << "none";
+    ss << " cpus " << hardwareCpus << " affinity " << affinityCpus << " quota ";
+    if (cpuQuota > 0) ss << cpuQuota; else ss << "none";
+    return ss.str();
+}
+
+#ifdef __linux__
+
+// First two fields of a cgroup file
+static bool readFields(const std::string &filename, std::string &first, std::string &second) {
+    std::ifstream file(filename);
+    second.clear();
+    return bool(file >> first) && (file >> second, true);
+}
+
+// Path of each controller from /proc/self/cgroup, the v2 unified hierarchy is the empty controller
+static std::map<std::string, std::string> cgroupPaths() {
+    std::map<std::string, std::string> paths;
+    std::ifstream file("/proc/self/cgroup");
+    std::string line;
+
+    while (std::getline(file, line)) {
+        size_t first = line.find(':'), second = line.find(':', first + 1);
+        if (first == std::string::npos || second == std::string::npos) continue;
+
+        std::istringstream controllers(line.substr(first + 1, second - first - 1));
+        std::string controller, path = line.substr(second + 1);
+
+        if (controllers.peek() == EOF) paths[""] = path;
+        while (std::getline(controllers, controller, ',')) paths[controller] = path;
+    }
+
+    return paths;
+}
+
+// The limits of the ancestors apply too, and in a container the own cgroup of the process is often mounted as the root
+template<typename Visitor>
+static void visitCgroups(const std::string &mount, std::string path, Visitor &&visit) {
+    while (true) {
+        visit(mount + path);
+        if (path.empty()) break;
+
+        path = path.substr(0, path.find_last_of('/'));
+    }
+}
+
+static void readCgroupLimits(SystemResources &resources) {
+    std::map<std::string, std::string> paths = cgroupPaths();
+    std::string a, b;
+
+    auto limitMemory = [&](size_t limit) {
+        // Unlimited v1 cgroups report a huge value
+        if (limit > 0 && (resources.physicalMemory == 0 || limit < resources.physicalMemory))
+            resources.memoryLimit = resources.memoryLimit ? std::min(resources.memoryLimit, limit) : limit;
+    };
+    auto limitCpu = [&](double quota) {
+        if (quota > 0) resources.cpuQuota = resources.cpuQuota > 0 ? std::min(resources.cpuQuota, quota) : quota;
+    };
+
+    if (paths.contains("")) {
+        visitCgroups("/sys/fs/cgroup", paths[""], [&](const std::string &dir) {
+            if (readFields(dir + "/memory.max", a, b) && a != "max")
+                limitMemory(std::stoull(a));
+            if (readFields(dir + "/cpu.max", a, b) && a != "max" && !b.empty())
+                limitCpu(std::stod(a) / std::stod(b));
+        });
+    }
+
+    if (paths.contains("memory")) {
+        visitCgroups("/sys/fs/cgroup/memory", paths["memory"], [&](const std::string &dir) {
+            if (readFields(dir + "/memory.limit_in_bytes", a, b))
+                limitMemory(std::stoull(a));
+        });
+    }
+
+    if (paths.contains("cpu")) {
+        for (const char *mount : {"/sys/fs/cgroup/cpu", "/sys/fs/cgroup/cpu,cpuacct"}) {
+            visitCgroups(mount, paths["cpu"], [&](const std::string &dir) {
+                std::string period;
+                if (readFields(dir + "/cpu.cfs_quota_us", a, b) && readFields(dir + "/cpu.cfs_period_us", period, b) && std::stoll(a) > 0)
+                    limitCpu(std::stod(a) / std::stod(period));
+            });
+        }
+    }
+}
+
+SystemResources readSystemResources() {
+    SystemResources resources;
+    resources.hardwareCpus = std::max(1u, std::thread::hardware_concurrency());
+    resources.physicalMemory = size_t(sysconf(_SC_PHYS_PAGES)) * size_t(sysconf(_SC_PAGESIZE));
+
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+        resources.affinityCpus = CPU_COUNT(&set);
+
+    try {
+        readCgroupLimits(resources);
+    } catch (const std::exception &) {
+        // Unexpected file content, the limits read so far are kept
+    }
+
+    return resources;
+}
+
+#else
+
+SystemResources readSystemResources() {
+    SystemResources resources;
+    resources.hardwareCpus = std::max(1u, std::thread::hardware_concurrency());
+    return resources;
+}
+
+#endif
+
+int availableCpus() {
+    return readSystemResources().availableCpus();
+}
+
+size_t autoHashSize(const SystemResources &resources, size_t reserved) {
+    size_t memory = resources.availableMemory();
+    if (memory == 0) return TT_DEFAULT_SIZE / MB;
+    if (memory <= reserved) return 1;
+
+    size_t size = (memory - reserved) / HashMemoryDiv / MB;
+    if (size == 0) return 1;
+
+    // Power of two, rounded down
+    return std::min(MaxHashSize, size_t(1) << (63 - __builtin_clzll(size)));
+}
+
+} /* namespace Belette */
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace Belette {
+
+// Memory and CPUs the process can use: machine, cgroup (v1 or v2) limits and CPU affinity
+struct SystemResources {
+    size_t physicalMemory = 0;
+    size_t memoryLimit = 0; // cgroup, 0 when unlimited
+    double cpuQuota = 0.0;  // cgroup, in CPUs, 0 when unlimited
+    int affinityCpus = 0;
+    int hardwareCpus = 0;
+
+    size_t availableMemory() const;
+    int availableCpus() const;
+    std::string str() const;
+};
+
+SystemResources readSystemResources();
+
+// Number of CPUs the process can actually run on, at least 1
+int availableCpus();
+
+// Transposition table size in MB fitting in the available memory, reserved bytes are kept for the rest of the process
+size_t autoHashSize(const SystemResources &resources, size_t reserved);
+
+} /* namespace Belette */
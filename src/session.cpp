@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <iomanip>
+#include <map>
+#include <signal.h>
+#include "session.h"
+#include "uciprocess.h"
+#include "uci.h"
+
+namespace Belette {
+
+constexpr TimeMs BannerTimeout = 1000;
+constexpr TimeUs TailGrace = 1000000; // Waiting for the last replies once all the inputs are sent
+
+SessionRecorder::SessionRecorder(const std::string &filename): file(filename), startTime(nowUs()) {
+    file << "# Belette " << VERSION << " session" << std::endl;
+}
+
+std::vector<SessionEvent> readSession(const std::string &filename) {
+    std::vector<SessionEvent> events;
+    std::ifstream file(filename);
+    std::string line;
+
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+
+        std::istringstream is(line);
+        SessionEvent event;
+        std::string direction;
+
+        if (!(is >> event.time >> direction) || (direction != "<" && direction != ">")) continue;
+
+        event.input = direction == "<";
+        std::getline(is >> std::ws, event.text);
+        events.push_back(event);
+    }
+
+    return events;
+}
+
+static std::string firstToken(const std::string &str) {
+    std::istringstream is(str);
+    std::string token;
+    is >> token;
+    return token;
+}
+
+// Replay must not write over the files of the recorded engine
+static bool touchesFiles(const std::string &input) {
+    return input.starts_with("setoption") && (input.find("Log File") != std::string::npos || input.find("Session File") != std::string::npos);
+}
+
+// Reply closing the commands that have one
+static const char *expectedReply(const std::string &command) {
+    if (command == "uci") return "uciok";
+    if (command == "isready") return "readyok";
+    if (command == "go" || command == "stop") return "bestmove";
+    return nullptr;
+}
+
+struct Reply {
+    std::string command;
+    std::string text;
+    TimeUs latency = -1; // No reply
+};
+
+// Reply to each of the inputs, in input order. The replies of a kind come in the order of their commands,
+// possibly after later inputs: a replay does not wait for the replies before sending the next input
+static std::vector<Reply> findReplies(const std::vector<SessionEvent> &events) {
+    std::vector<Reply> replies;
+    std::vector<TimeUs> times; // Of the inputs
+    std::map<std::string, std::deque<size_t>> waiting; // Inputs waiting for a reply, by reply
+
+    for (const SessionEvent &event : events) {
+        if (event.input) {
+            std::string token = firstToken(event.text);
+            const char *expected = expectedReply(token);
+
+            // A stop without search running is not answered
+            if (expected && (token != "stop" || !waiting["bestmove"].empty()))
+                waiting[expected].push_back(replies.size());
+
+            replies.push_back({event.text, "", -1});
+            times.push_back(event.time);
+            continue;
+        }
+
+        for (auto &[prefix, inputs] : waiting) {
+            if (inputs.empty() || !event.text.starts_with(prefix)) continue;
+
+            // A bestmove answers the oldest search and the stops sent during it
+            do {
+                size_t i = inputs.front();
+                inputs.pop_front();
+
+                replies[i].text = event.text;
+                replies[i].latency = event.time - times[i];
+            } while (!inputs.empty() && firstToken(replies[inputs.front()].command) == "stop");
+
+            break;
+        }
+    }
+
+    return replies;
+}
+
+static std::string formatMs(TimeUs us, bool sign = false) {
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(3) << (sign && us >= 0 ? "+" : "") << us / 1000.0 << " ms";
+    return ss.str();
+}
+
+void replay(const std::string &filename, const ReplayOptions &options) {
+    std::vector<SessionEvent> recorded = readSession(filename);
+    std::erase_if(recorded, [](const SessionEvent &event) { return event.input && touchesFiles(event.text); });
+
+    auto firstInput = std::find_if(recorded.begin(), recorded.end(), [](const SessionEvent &event) { return event.input; });
+    if (firstInput == recorded.end()) {
+        console << "No UCI input found in " << filename << std::endl;
+        return;
+    }
+
+    // A dead engine must not kill the replay when we write to its pipe
+    signal(SIGPIPE, SIG_IGN);
+
+    UciProcess process;
+    if (!process.spawn(enginePath(options.engine))) {
+        console << "Unable to start " << options.engine << std::endl;
+        return;
+    }
+
+    // Skip the banner printed at startup, before any command
+    std::string line;
+    process.readLine(line, BannerTimeout);
+
+    std::vector<SessionEvent> replayed;
+    TimeUs origin = firstInput->time, lastInput = origin, start = nowUs();
+
+    // False once the engine has exited
+    auto readUntil = [&](TimeUs deadline) {
+        while (nowUs() < deadline) {
+            if (process.readLine(line, (deadline - nowUs() + 999) / 1000))
+                replayed.push_back({nowUs() - start, false, line});
+            else if (nowUs() < deadline)
+                return false;
+        }
+        return true;
+    };
+
+    bool running = true;
+    for (const SessionEvent &event : recorded) {
+        if (!event.input) continue;
+
+        running = running && readUntil(start + TimeUs((event.time - origin) / options.speed));
+        if (!running) break;
+
+        process.send(event.text);
+        replayed.push_back({nowUs() - start, true, event.text});
+        lastInput = event.time;
+    }
+
+    // The search durations do not scale, so the outputs after the last input are waited for in real time
+    if (running) readUntil(nowUs() + (recorded.back().time - lastInput) + TailGrace);
+    process.stop();
+
+    // Latency of the commands with a reply
+    std::vector<Reply> expected = findReplies(recorded), actual = findReplies(replayed);
+    size_t nbCompared = 0, nbMissing = 0, worst = 0;
+    TimeUs sumDeviation = 0, maxDeviation = 0;
+
+    for (size_t i = 0; i < std::min(expected.size(), actual.size()); i++) {
+        if (expected[i].latency < 0) continue;
+
+        if (actual[i].latency < 0) {
+            console << "info string replay #" << i + 1 << " " << expected[i].command << " no reply" << std::endl;
+            nbMissing++;
+            continue;
+        }
+
+        TimeUs deviation = actual[i].latency - expected[i].latency;
+        console << "info string replay #" << i + 1 << " " << expected[i].command
+                << " recorded " << formatMs(expected[i].latency) << " replayed " << formatMs(actual[i].latency)
+                << " deviation " << formatMs(deviation, true) << std::endl;
+
+        nbCompared++;
+        sumDeviation += std::abs(deviation);
+        if (std::abs(deviation) >= maxDeviation) {
+            maxDeviation = std::abs(deviation);
+            worst = i;
+        }
+    }
+
+    console << "Replayed " << actual.size() << "/" << expected.size() << " inputs";
+    if (options.speed != 1.0) console << " at speed " << options.speed;
+    console << std::endl;
+
+    console << "Latency " << nbCompared << " replies compared, " << nbMissing << " missing";
+    if (nbCompared > 0) {
+        console << ", mean deviation " << formatMs(sumDeviation / TimeUs(nbCompared))
+                << ", max " << formatMs(maxDeviation) << " (#" << worst + 1 << " " << firstToken(expected[worst].command) << ")";
+    }
+    console << std::endl;
+
+    // Replies diff, the bestmoves of searches limited by time may legitimately differ
+    size_t nbReplies = 0, nbDiffs = 0;
+
+    for (size_t i = 0; i < std::min(expected.size(), actual.size()); i++) {
+        if (expected[i].latency < 0 && actual[i].latency < 0) continue;
+
+        nbReplies++;
+        if (expected[i].text == actual[i].text) continue;
+
+        nbDiffs++;
+        console << "info string replay #" << i + 1 << " " << expected[i].command
+                << " recorded '" << expected[i].text << "' replayed '" << actual[i].text << "'" << std::endl;
+    }
+
+    console << "Replies " << nbReplies - nbDiffs << "/" << nbReplies << " identical" << std::endl;
+}
+
+} /* namespace Belette */
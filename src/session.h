@@ -0,0 +1,51 @@
+#pragma once
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "utils.h"
+
+namespace Belette {
+
+// A line of a UCI session, time in microseconds from the start of the recording
+struct SessionEvent {
+    TimeUs time;
+    bool input;
+    std::string text;
+};
+
+// Record the UCI inputs and outputs with their timestamps, one "<time> <|> <line>" line each
+class SessionRecorder {
+public:
+    SessionRecorder(const std::string &filename);
+
+    template <class T> void append(const T& x, bool isInput) {
+        if (buffer.rdbuf()->in_avail() == 0) input = isInput;
+        buffer << x;
+
+        if (buffer.str().ends_with('\n')) {
+            file << (nowUs() - startTime) << (input ? " < " : " > ") << buffer.str();
+            file.flush();
+            buffer.str(std::string()); // clear buffer
+        }
+    }
+
+private:
+    std::ofstream file;
+    std::stringstream buffer;
+    TimeUs startTime;
+    bool input = false;
+};
+
+std::vector<SessionEvent> readSession(const std::string &filename);
+
+struct ReplayOptions {
+    std::string engine = "self";
+    double speed = 1.0; // Time between the inputs is divided by the speed
+};
+
+// Feed the inputs of a session to an engine with the recorded timing, then compare the replies and their latencies
+void replay(const std::string &filename, const ReplayOptions &options);
+
+} /* namespace Belette */
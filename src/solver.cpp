@@ -0,0 +1,461 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <climits>
+#include <mutex>
+#include <span>
+#include <thread>
+#include "solver.h"
+#include "movegen.h"
+#include "uci.h"
+
+namespace Belette {
+
+// Proof and disproof numbers are kept from the point of view of the side to move: phi is the proof
+// number when the attacker is to move and the disproof number otherwise, delta is the other one.
+// A node is won for the side to move when phi == 0 and lost when delta == 0
+using ProofNumber = uint32_t;
+
+constexpr ProofNumber PN_INFINITE = 1u << 30;
+
+constexpr int MaxSolvePly = 1000;         // Deeper positions count as failures for the attacker
+constexpr int EntriesPerBucket = 4;
+constexpr int NbLocks = 1024;             // Entries are locked by stripes of buckets
+constexpr int GcFillPermille = 900;       // Table filling triggering a garbage collection,
+constexpr int GcKeepPermille = 500;       // which keeps the entries of the largest subtrees up to this filling
+constexpr int EpsilonDiv = 4;             // Threshold of the best child is 1 + 1/EpsilonDiv times the second best (Pawlewicz)
+constexpr size_t ProgressNodes = 1 << 16; // Nodes between two progress checks
+constexpr TimeMs ProgressInterval = 1000;
+
+struct PnEntry {
+    uint64_t hash = 0;
+    ProofNumber phi = 1;
+    ProofNumber delta = 1;
+    uint32_t amount = 0;   // Nodes searched below, the smallest subtrees are collected first
+    uint16_t distance = 0; // Plies to mate of the proof, for the nodes won by the attacker
+    bool pathDependent = false; // Disproof relying on a repetition of the path or on the ply limit
+}; // 24 Bytes
+
+static inline ProofNumber addProofNumbers(ProofNumber a, ProofNumber b) {
+    return (a >= PN_INFINITE || b >= PN_INFINITE) ? PN_INFINITE : ProofNumber(std::min<uint64_t>(uint64_t(a) + b, PN_INFINITE - 1));
+}
+
+// Shared by the solver threads, each bucket is protected by the lock of its stripe
+class PnTable {
+public:
+    PnTable(size_t size) {
+        nbBuckets = 1;
+        while (nbBuckets * 2 * EntriesPerBucket * sizeof(PnEntry) <= size) nbBuckets *= 2;
+        entries.resize(nbBuckets * EntriesPerBucket);
+    }
+
+    bool lookup(uint64_t hash, PnEntry &result) {
+        size_t bucket = hash & (nbBuckets - 1);
+        std::lock_guard<std::mutex> lock(locks[bucket % NbLocks]);
+
+        for (const PnEntry &entry : bucketEntries(bucket)) {
+            if (entry.hash != hash || entry.amount == 0) continue;
+
+            result = entry;
+            return true;
+        }
+
+        return false;
+    }
+
+    // The entry of the smallest subtree of the bucket is replaced when there is no room left
+    void store(const PnEntry &node) {
+        size_t bucket = node.hash & (nbBuckets - 1);
+        std::lock_guard<std::mutex> lock(locks[bucket % NbLocks]);
+
+        std::span<PnEntry> candidates = bucketEntries(bucket);
+        PnEntry *replace = &candidates[0];
+
+        for (PnEntry &entry : candidates) {
+            if (entry.hash == node.hash && entry.amount > 0) { replace = &entry; break; }
+            if (entry.amount < replace->amount) replace = &entry;
+        }
+
+        if (replace->amount == 0) used++;
+        *replace = node;
+        replace->amount = std::max(node.amount, 1u);
+    }
+
+    inline bool needsCollection() const { return used * 1000 > entries.size() * GcFillPermille; }
+    inline size_t hashfull() const { return used * 1000 / entries.size(); }
+
+    // Garbage collection: remove the entries of the smallest subtrees, the cheapest to search again
+    void collect() {
+        if (collecting.exchange(true)) return;
+
+        // Smallest power of two bound on the amounts keeping at most GcKeepPermille of the table
+        std::array<size_t, 33> histogram {};
+        for (const PnEntry &entry : entries)
+            if (entry.amount > 0) histogram[32 - __builtin_clz(entry.amount)]++;
+
+        size_t keep = 0, limit = entries.size() * GcKeepPermille / 1000;
+        int bound = 33;
+        while (bound > 1 && keep + histogram[bound - 1] <= limit) keep += histogram[--bound];
+
+        for (size_t bucket = 0; bucket < nbBuckets; bucket++) {
+            std::lock_guard<std::mutex> lock(locks[bucket % NbLocks]);
+
+            for (PnEntry &entry : bucketEntries(bucket)) {
+                if (entry.amount > 0 && 32 - __builtin_clz(entry.amount) < bound) {
+                    entry.amount = 0;
+                    used--;
+                }
+            }
+        }
+
+        collecting = false;
+    }
+
+private:
+    inline std::span<PnEntry> bucketEntries(size_t bucket) { return std::span<PnEntry>(&entries[bucket * EntriesPerBucket], EntriesPerBucket); }
+
+    std::vector<PnEntry> entries;
+    size_t nbBuckets;
+    std::array<std::mutex, NbLocks> locks;
+    std::atomic<size_t> used = 0;
+    std::atomic<bool> collecting = false;
+};
+
+struct SolverShared {
+    SolverShared(size_t hashSize): table(hashSize) { }
+
+    PnTable table;
+    std::atomic<size_t> nbNodes = 0;
+    std::atomic<bool> stop = false;
+    size_t maxNodes = 0;
+    TimeMs startTime = 0;
+    TimeMs lastProgress = 0;
+    uint64_t rootHash = 0;
+
+    // Nodes being searched by a thread, the other threads prefer their siblings
+    bool trackBusy = false;
+    std::array<std::atomic<uint8_t>, 1 << 16> busy {};
+
+    inline std::atomic<uint8_t> &busyFlag(uint64_t hash) { return busy[hash & (busy.size() - 1)]; }
+};
+
+class PnSolver {
+public:
+    PnSolver(const Position &pos, SolverShared &shared_, int id_):
+        position(pos), shared(shared_), attacker(pos.getSideToMove()), id(id_),
+        maxPly(std::min<int>(MaxSolvePly, MAX_HISTORY - pos.historySize() - 2)) { }
+
+    void run() {
+        while (!shared.stop) {
+            PnEntry root = mid(PN_INFINITE, PN_INFINITE);
+            if (root.phi == 0 || root.delta == 0) shared.stop = true;
+        }
+    }
+
+    std::vector<Move> extractPv(bool &complete);
+
+private:
+    struct Child : PnEntry {
+        Move move = MOVE_NONE;
+        bool draw = false;
+    };
+
+    Position position;
+    SolverShared &shared;
+    Side attacker;
+    int id;
+    int maxPly;
+    std::vector<uint64_t> path;
+    size_t localNodes = 0;
+
+    inline bool isOrNode() const { return position.getSideToMove() == attacker; }
+
+    // Won by the attacker: proof number is 0
+    inline bool isProven(const PnEntry &node) const { return (isOrNode() ? node.phi : node.delta) == 0; }
+
+    // The side to move has no legal move
+    inline void terminal(PnEntry &node) const {
+        bool lost = position.inCheck() || isOrNode(); // Stalemate is a failure for the attacker
+        node.phi = lost ? PN_INFINITE : 0;
+        node.delta = lost ? 0 : PN_INFINITE;
+    }
+
+    inline void failure(PnEntry &node) const {
+        node.phi = isOrNode() ? PN_INFINITE : 0;
+        node.delta = isOrNode() ? 0 : PN_INFINITE;
+    }
+
+    // Repetition of the path or too deep, a failure for the attacker that may not hold by another path
+    inline void draw(PnEntry &node) const {
+        failure(node);
+        node.pathDependent = true;
+    }
+
+    // Without pawns, the attacker never mates with its king alone, nor with a single minor piece against a bare
+    // king. Its material only decreases and a bare king stays bare, so it holds for the whole subtree
+    inline bool cannotMate() const {
+        if (position.getPiecesBB(attacker, PAWN)) return false;
+
+        int nbPieces = popcount(position.getPiecesBB(attacker)) - 1;
+        int nbMinors = popcount(position.getPiecesBB(attacker, KNIGHT, BISHOP));
+
+        return nbPieces == 0 || (nbPieces == 1 && nbMinors == 1 && popcount(position.getPiecesBB(~attacker)) == 1);
+    }
+
+    // Disproofs relying on the path are not reused, the node is searched again from the new path
+    inline bool probe(uint64_t hash, PnEntry &node) {
+        PnEntry entry;
+        if (!shared.table.lookup(hash, entry) || entry.pathDependent) return false;
+
+        node = entry;
+        return true;
+    }
+
+    void countNode() {
+        size_t nodes = shared.nbNodes.fetch_add(1, std::memory_order_relaxed) + 1;
+        localNodes++;
+
+        if (shared.maxNodes > 0 && nodes >= shared.maxNodes) shared.stop = true;
+
+        if (id == 0 && localNodes % ProgressNodes == 0 && now() - shared.lastProgress >= ProgressInterval)
+            progress(nodes);
+    }
+
+    void progress(size_t nodes) {
+        PnEntry root;
+        shared.table.lookup(shared.rootHash, root);
+
+        TimeMs elapsed = std::max<TimeMs>(now() - shared.startTime, 1);
+        shared.lastProgress = now();
+
+        console << "info nodes " << nodes << " nps " << nodes * 1000 / elapsed << " time " << elapsed
+                << " hashfull " << shared.table.hashfull() << " string pn " << root.phi << " dn " << root.delta << std::endl;
+    }
+
+    void expand(std::vector<Child> &children);
+    PnEntry mid(ProofNumber thPhi, ProofNumber thDelta);
+};
+
+// Children with their initial proof numbers: after an attacker move, the defender mobility
+void PnSolver::expand(std::vector<Child> &children) {
+    MoveList moves;
+    generateLegalMoves(position, moves);
+
+    for (Move move : moves) {
+        Child child;
+        child.move = move;
+
+        position.doMove(move);
+        countNode();
+        child.hash = position.hash();
+
+        if (std::find(path.begin(), path.end(), child.hash) != path.end() || int(path.size()) >= maxPly) {
+            child.draw = true;
+            draw(child);
+        } else if (cannotMate()) {
+            failure(child);
+        } else if (!probe(child.hash, child)) {
+            size_t nbMoves = 0;
+            enumerateLegalMoves(position, [&](Move) { nbMoves++; return true; });
+
+            if (nbMoves == 0) {
+                terminal(child);
+            } else if (!isOrNode()) {
+                child.delta = ProofNumber(nbMoves); // Proof number of the defender node
+            }
+        }
+
+        position.undoMove(move);
+        children.push_back(child);
+    }
+}
+
+// Multiple iterative deepening (Nagai): search the node until its proof numbers reach the thresholds. Its entry
+// is returned, as the table does not give back the disproofs relying on the path
+PnEntry PnSolver::mid(ProofNumber thPhi, ProofNumber thDelta) {
+    PnEntry node;
+    size_t startNodes = localNodes;
+
+    node.hash = position.hash();
+    shared.table.lookup(node.hash, node);
+
+    std::vector<Child> children;
+    expand(children);
+
+    path.push_back(node.hash);
+
+    while (true) {
+        // The other threads may have updated the children
+        for (Child &child : children)
+            if (!child.draw) probe(child.hash, child);
+
+        // The node is won when one child is lost for its side to move, lost when all of them are won
+        node.phi = PN_INFINITE;
+        node.delta = 0;
+        for (const Child &child : children) {
+            node.phi = std::min(node.phi, child.delta);
+            node.delta = addProofNumbers(node.delta, child.phi);
+        }
+
+        if (children.empty()) terminal(node);
+
+        // The attacker fails in all the children of an OR node, in one of the children of an AND node. Proofs
+        // never rely on a draw, the disproofs do when the failing children they need all do
+        bool orNode = isOrNode();
+        node.pathDependent = false;
+
+        if ((orNode ? node.delta : node.phi) == 0) {
+            node.pathDependent = !orNode;
+
+            for (const Child &child : children) {
+                if ((orNode ? child.phi : child.delta) != 0) continue;
+                if (orNode) node.pathDependent |= child.pathDependent;
+                else node.pathDependent &= child.pathDependent;
+            }
+        }
+
+        if (node.phi >= thPhi || node.delta >= thDelta || shared.stop) break;
+
+        // Most proving child, the helper threads prefer the ones no other thread is searching
+        auto best = children.begin(), selected = children.end();
+
+        for (auto it = children.begin(); it != children.end(); ++it) {
+            if (it->delta < best->delta) best = it;
+            if (shared.trackBusy && shared.busyFlag(it->hash) == 0 && (selected == children.end() || it->delta < selected->delta))
+                selected = it;
+        }
+
+        auto secondBest = [&](std::vector<Child>::iterator chosen) {
+            ProofNumber second = PN_INFINITE;
+            for (auto it = children.begin(); it != children.end(); ++it)
+                if (it != chosen) second = std::min(second, it->delta);
+            return second;
+        };
+        auto childThreshold = [&](ProofNumber second) {
+            return ProofNumber(std::min<uint64_t>(thPhi, std::max<uint64_t>(uint64_t(second) + 1, uint64_t(second) + second / EpsilonDiv)));
+        };
+
+        ProofNumber childThDelta = childThreshold(secondBest(best));
+        if (selected != children.end() && selected != best) {
+            ProofNumber threshold = childThreshold(secondBest(selected));
+            if (selected->delta < threshold) {
+                best = selected;
+                childThDelta = threshold;
+            }
+        }
+
+        ProofNumber childThPhi = thDelta >= PN_INFINITE ? PN_INFINITE : thDelta - node.delta + best->phi;
+
+        if (shared.trackBusy) shared.busyFlag(best->hash)++;
+        position.doMove(best->move);
+
+        static_cast<PnEntry &>(*best) = mid(childThPhi, childThDelta);
+
+        position.undoMove(best->move);
+        if (shared.trackBusy) shared.busyFlag(best->hash)--;
+    }
+
+    path.pop_back();
+
+    // Length of the proof: the attacker picks the shortest mate, the defender the longest one
+    if (isProven(node)) {
+        bool orNode = isOrNode();
+        int distance = orNode ? INT_MAX : 0;
+
+        for (const Child &child : children) {
+            if (orNode && child.delta == 0) distance = std::min<int>(distance, child.distance);
+            if (!orNode) distance = std::max<int>(distance, child.distance);
+        }
+
+        node.distance = uint16_t(std::min(distance + 1, UINT16_MAX));
+    }
+
+    node.amount = uint32_t(std::min<uint64_t>(uint64_t(node.amount) + (localNodes - startNodes), UINT32_MAX));
+    shared.table.store(node);
+
+    if (shared.table.needsCollection()) shared.table.collect();
+
+    return node;
+}
+
+// Follow the proof distances down to the mate, they decrease strictly along the line
+std::vector<Move> PnSolver::extractPv(bool &complete) {
+    std::vector<Move> pv;
+    PnEntry node;
+
+    path.clear();
+    if (!shared.table.lookup(position.hash(), node)) return pv;
+
+    int distance = node.distance;
+
+    while (distance > 0) {
+        path.push_back(position.hash());
+
+        std::vector<Child> children;
+        expand(children);
+
+        bool orNode = isOrNode();
+        auto best = children.end();
+
+        for (auto it = children.begin(); it != children.end(); ++it) {
+            if (it->draw || (orNode ? it->delta : it->phi) != 0 || it->distance >= distance) continue;
+
+            if (best == children.end() || (orNode ? it->distance < best->distance : it->distance > best->distance))
+                best = it;
+        }
+
+        if (best == children.end()) break;
+
+        pv.push_back(best->move);
+        position.doMove(best->move);
+        distance = best->distance;
+    }
+
+    // Distances stored by other threads may be stale, the line itself is the tightest bound
+    complete = position.inCheck() && enumerateLegalMoves(position, [](Move) { return false; });
+
+    for (auto it = pv.rbegin(); it != pv.rend(); ++it) position.undoMove(*it);
+    return pv;
+}
+
+SolveResult solveMate(const Position &pos, const SolveOptions &options) {
+    auto shared = std::make_unique<SolverShared>(options.hashSize * 1024 * 1024);
+    shared->maxNodes = options.maxNodes;
+    shared->startTime = shared->lastProgress = now();
+    shared->rootHash = pos.hash();
+    shared->trackBusy = options.threads > 1;
+
+    int nbThreads = std::max(1, options.threads);
+    std::vector<std::unique_ptr<PnSolver>> solvers;
+    for (int i = 0; i < nbThreads; i++)
+        solvers.push_back(std::make_unique<PnSolver>(pos, *shared, i));
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < nbThreads; i++)
+        threads.emplace_back([&, i] { solvers[i]->run(); });
+
+    solvers[0]->run();
+    for (auto &th : threads) th.join();
+
+    SolveResult result;
+    PnEntry root;
+
+    result.nbNodes = shared->nbNodes;
+    result.elapsed = now() - shared->startTime;
+    result.hashfull = shared->table.hashfull();
+
+    if (shared->table.lookup(pos.hash(), root)) {
+        if (root.phi == 0) {
+            result.status = SOLVE_PROVEN;
+            bool complete;
+            result.pv = solvers[0]->extractPv(complete);
+            result.distance = complete ? int(result.pv.size()) : root.distance;
+        } else if (root.delta == 0) {
+            result.status = root.pathDependent ? SOLVE_UNRESOLVED : SOLVE_DISPROVEN;
+        }
+    }
+
+    return result;
+}
+
+} /* namespace Belette */
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vector>
+#include "position.h"
+#include "utils.h"
+
+namespace Belette {
+
+struct SolveOptions {
+    size_t maxNodes = 0;  // 0 for no limit
+    int threads = 1;      // Searching the same tree, sharing the proof number table
+    size_t hashSize = 16; // In MB, for the proof number table
+};
+
+enum SolveStatus {
+    SOLVE_UNKNOWN,   // Node limit reached
+    SOLVE_PROVEN,    // Forced mate
+    SOLVE_DISPROVEN, // No forced mate
+    SOLVE_UNRESOLVED // No mate found, but the disproof relies on repetitions or the ply limit
+};
+
+struct SolveResult {
+    SolveStatus status = SOLVE_UNKNOWN;
+    std::vector<Move> pv; // Mating line when proven
+    int distance = 0;     // Plies to mate of the proof, an upper bound of the shortest mate
+    size_t nbNodes = 0;
+    TimeMs elapsed = 0;
+    size_t hashfull = 0;  // Per mille
+};
+
+// Depth-first proof-number search (df-pn) of a forced mate by the side to move. The pv follows the
+// proof found, not necessarily the shortest mate. Repetitions of the current path count as failures
+// for the attacker, the disproofs relying on them are searched again when reached by another path and
+// never reported as SOLVE_DISPROVEN. The position must be legal, the side not to move not in check
+SolveResult solveMate(const Position &pos, const SolveOptions &options);
+
+} /* namespace Belette */
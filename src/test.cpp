@@ -45,6 +45,17 @@ void run() {
             nbFailed++;
         }
 
+        // The move picker must give the legal moves, its generator may be the pseudo-legal one. One ply less, it is slower
+        size_t legal = perft<false>(pos, t.depth - 1);
+        size_t picked = perftmp<false>(pos, t.depth - 1);
+
+        if (picked == legal) {
+            console << "  SUCCESS - movepicker " << legal << " == " << picked << std::endl;
+        } else {
+            console << "  FAILED! - movepicker " << legal << " != " << picked << std::endl;
+            nbFailed++;
+        }
+
         i++;
     }
 
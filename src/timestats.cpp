@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include "timestats.h"
+
+namespace Belette {
+
+const char *stopReasonName(StopReason reason) {
+    static const char *names[NB_STOP_REASON] = {
+        "none", "depth", "maxply", "time", "movetime", "nodes", "single", "mate", "onlymove", "mateproven", "stop"
+    };
+    return names[reason];
+}
+
+std::string TimeRecord::str() const {
+    std::ostringstream ss;
+    ss << "timeleft " << timeLeft << " inc " << increment << " movestogo " << movesToGo
+       << " allocated " << allocated << " elapsed " << elapsed << " depth " << depth
+       << " stop " << stopReasonName(stopReason) << " overshoot " << overshoot()
+       << " cpu " << cpu << " contention " << int(contention * 100 + 0.5) << "%";
+    return ss.str();
+}
+
+const char *TimeRecord::csvHeader() {
+    return "timeleft,inc,movestogo,allocated,elapsed,depth,stop,overshoot,cpu,contention";
+}
+
+std::string TimeRecord::csv() const {
+    std::ostringstream ss;
+    ss << timeLeft << ',' << increment << ',' << movesToGo << ',' << allocated << ',' << elapsed << ','
+       << depth << ',' << stopReasonName(stopReason) << ',' << overshoot() << ',' << cpu << ','
+       << std::fixed << std::setprecision(3) << contention;
+    return ss.str();
+}
+
+size_t TimeStats::record(const TimeRecord &record) {
+    std::lock_guard<std::mutex> lock(mutex);
+    records.push_back(record);
+    return records.size();
+}
+
+void TimeStats::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    records.clear();
+}
+
+std::string TimeStats::summary() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::ostringstream ss;
+
+    ss << "Time management over " << records.size() << " searches" << std::endl;
+    if (records.empty()) return ss.str();
+
+    double allocated = 0, elapsed = 0, depth = 0, overshoot = 0, contention = 0, maxContention = 0;
+    TimeMs maxOvershoot = 0, minTimeLeft = records.front().timeLeft;
+    size_t nbOvershoots = 0;
+    size_t reasons[NB_STOP_REASON] = {};
+
+    for (const TimeRecord &r : records) {
+        allocated += r.allocated;
+        elapsed += r.elapsed;
+        depth += r.depth;
+        overshoot += r.overshoot();
+        nbOvershoots += r.overshoot() > 0;
+        maxOvershoot = std::max(maxOvershoot, r.overshoot());
+        minTimeLeft = std::min(minTimeLeft, r.timeLeft);
+        reasons[r.stopReason]++;
+        contention += r.contention;
+        maxContention = std::max(maxContention, r.contention);
+    }
+
+    double n = double(records.size());
+    ss << std::fixed << std::setprecision(1)
+       << "allocated " << allocated / n << " ms, elapsed " << elapsed / n << " ms, usage "
+       << (allocated > 0 ? 100.0 * elapsed / allocated : 0.0) << "%" << std::endl
+       << "overshoot " << overshoot / n << " ms, max " << maxOvershoot << " ms, in " << nbOvershoots << " searches" << std::endl
+       << "depth " << depth / n << ", min time left " << minTimeLeft << " ms" << std::endl
+       << "contention " << 100 * contention / n << "%, max " << 100 * maxContention << "%" << std::endl
+       << "stop";
+
+    for (int i = STOP_DEPTH; i < NB_STOP_REASON; i++) {
+        if (reasons[i]) ss << " " << stopReasonName(StopReason(i)) << " " << reasons[i];
+    }
+    ss << std::endl;
+
+    return ss.str();
+}
+
+} /* namespace Belette */
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "engine.h"
+#include "utils.h"
+
+namespace Belette {
+
+// Time manager inputs and decision for one search under tournament time, with its outcome
+struct TimeRecord {
+    TimeMs timeLeft;
+    TimeMs increment;
+    int movesToGo;
+    TimeMs allocated;
+    TimeMs elapsed; // Up to the bestmove
+    int depth;      // Last completed depth
+    StopReason stopReason;
+    TimeMs cpu;     // CPU time of the search thread
+    double contention;
+
+    inline TimeMs overshoot() const { return std::max<TimeMs>(0, elapsed - allocated); }
+
+    std::string str() const;       // Fields for an "info string" line
+    std::string csv() const;
+    static const char *csvHeader();
+};
+
+const char *stopReasonName(StopReason reason);
+
+// Time management records of the session, written by the search thread and read by the UCI thread
+class TimeStats {
+public:
+    size_t record(const TimeRecord &record); // Number of records of the session
+    void clear();
+    std::string summary();
+
+private:
+    std::mutex mutex;
+    std::vector<TimeRecord> records;
+};
+
+} /* namespace Belette */
@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <map>
+#include "treerecorder.h"
+#include "uci.h"
+
+namespace Belette {
+
+bool TreeRecorder::open(const std::string &filename, int maxPly_, size_t maxNodes_) {
+    close();
+
+    file.open(filename, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+
+    file.write(TREE_MAGIC, sizeof(TREE_MAGIC));
+    buffer.reserve(BufferSize);
+    maxPly = maxPly_;
+    maxNodes = maxNodes_;
+    nbNodes = 0;
+
+    return true;
+}
+
+void TreeRecorder::close() {
+    if (!file.is_open()) return;
+
+    flush();
+    file.close();
+}
+
+void TreeRecorder::flush() {
+    file.write(reinterpret_cast<const char *>(buffer.data()), buffer.size() * sizeof(TreeRecord));
+    buffer.clear();
+}
+
+static const char *KindNames[NB_TREE_NODE_KIND] = { "root", "pv", "non-pv", "qs pv", "qs non-pv" };
+
+static const char *ReasonNames[NB_TREE_NODE_REASON] = {
+    "searched", "aborted", "mate distance", "draw", "max ply", "tt cutoff",
+    "rfp", "razoring", "nmp", "no move", "stand pat"
+};
+
+static inline double percent(size_t count, size_t total) {
+    return total ? 100.0 * count / total : 0.0;
+}
+
+void treestat(const std::string &filename, int nbSubtrees) {
+    std::ifstream file(filename, std::ios::binary);
+    char magic[sizeof(TREE_MAGIC)];
+
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, TREE_MAGIC, sizeof(magic)) != 0) {
+        console << "Invalid tree file " << filename << std::endl;
+        return;
+    }
+
+    std::vector<TreeRecord> records;
+    TreeRecord record;
+    while (file.read(reinterpret_cast<char *>(&record), sizeof(record)))
+        records.push_back(record);
+
+    if (records.empty()) {
+        console << "Empty tree file " << filename << std::endl;
+        return;
+    }
+
+    // Children are written before their parent: a stack of pending subtrees gives sizes and parents
+    const size_t nbRecords = records.size();
+    std::vector<size_t> subtreeSize(nbRecords, 1);
+    std::vector<size_t> parent(nbRecords, SIZE_MAX);
+    std::vector<size_t> pending;
+
+    for (size_t i = 0; i < nbRecords; i++) {
+        while (!pending.empty() && records[pending.back()].ply > records[i].ply) {
+            subtreeSize[i] += subtreeSize[pending.back()];
+            parent[pending.back()] = i;
+            pending.pop_back();
+        }
+        pending.push_back(i);
+    }
+
+    // Nodes per ply
+    std::map<int, std::array<size_t, NB_TREE_NODE_KIND>> byPly;
+    std::map<int, size_t> byDepth, ttHitsByPly;
+    size_t byReason[NB_TREE_NODE_REASON] = {}, byKind[NB_TREE_NODE_KIND] = {};
+
+    for (const TreeRecord &r : records) {
+        byPly[r.ply][r.kind]++;
+        byKind[r.kind]++;
+        byReason[std::min<int>(r.flags & 0x0F, NB_TREE_NODE_REASON - 1)]++;
+        if (r.kind < TREE_QS_PV) byDepth[r.depth]++;
+        if (r.flags & TREE_TT_HIT_FLAG) ttHitsByPly[r.ply]++;
+    }
+
+    console << "Nodes: " << nbRecords << std::endl;
+
+    for (int k = 0; k < NB_TREE_NODE_KIND; k++)
+        console << "  " << std::left << std::setw(14) << KindNames[k] << std::right << std::setw(12) << byKind[k]
+                << std::fixed << std::setprecision(1) << std::setw(7) << percent(byKind[k], nbRecords) << "%" << std::endl;
+
+    console << std::endl << "Return reasons:" << std::endl;
+    for (int r = 0; r < NB_TREE_NODE_REASON; r++) {
+        if (!byReason[r]) continue;
+        console << "  " << std::left << std::setw(14) << ReasonNames[r] << std::right << std::setw(12) << byReason[r]
+                << std::setw(7) << percent(byReason[r], nbRecords) << "%" << std::endl;
+    }
+
+    console << std::endl << " Ply       nodes      main        qs   tt hit" << std::endl;
+    for (const auto &[ply, kinds] : byPly) {
+        size_t main = kinds[TREE_ROOT] + kinds[TREE_PV] + kinds[TREE_NON_PV];
+        size_t qs = kinds[TREE_QS_PV] + kinds[TREE_QS_NON_PV];
+
+        console << std::setw(4) << ply << std::setw(12) << (main + qs) << std::setw(10) << main << std::setw(10) << qs
+                << std::setw(8) << percent(ttHitsByPly[ply], main + qs) << "%" << std::endl;
+    }
+
+    console << std::endl << "Depth       nodes" << std::endl;
+    for (auto it = byDepth.rbegin(); it != byDepth.rend(); ++it)
+        console << std::setw(5) << it->first << std::setw(12) << it->second << std::endl;
+
+    // Largest subtrees below the root
+    std::vector<size_t> order;
+    for (size_t i = 0; i < nbRecords; i++)
+        if (records[i].ply > 0) order.push_back(i);
+
+    size_t top = std::min<size_t>(nbSubtrees, order.size());
+    std::partial_sort(order.begin(), order.begin() + top, order.end(), [&](size_t a, size_t b) { return subtreeSize[a] > subtreeSize[b]; });
+
+    console << std::endl << "Largest subtrees:" << std::endl;
+
+    for (size_t n = 0; n < top; n++) {
+        size_t i = order[n];
+        const TreeRecord &r = records[i];
+
+        std::vector<Move> path;
+        for (size_t p = i; p != SIZE_MAX && records[p].ply > 0; p = parent[p])
+            path.push_back(Move(records[p].move));
+
+        console << std::setw(10) << subtreeSize[i] << " nodes (" << percent(subtreeSize[i], nbRecords) << "%)"
+                << " ply " << int(r.ply) << " depth " << int(r.depth) << " " << KindNames[r.kind]
+                << " window [" << r.alpha << ", " << r.beta << "] score " << r.score << " "
+                << ReasonNames[std::min<int>(r.flags & 0x0F, NB_TREE_NODE_REASON - 1)] << " path";
+
+        for (auto it = path.rbegin(); it != path.rend(); ++it)
+            console << " " << Uci::formatMove(*it);
+
+        console << std::endl;
+    }
+
+    console << std::defaultfloat;
+}
+
+} /* namespace Belette */
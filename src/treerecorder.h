@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <fstream>
+#include "chess.h"
+
+namespace Belette {
+
+enum TreeNodeKind : uint8_t {
+    TREE_ROOT,
+    TREE_PV,
+    TREE_NON_PV,
+    TREE_QS_PV,
+    TREE_QS_NON_PV,
+    NB_TREE_NODE_KIND
+};
+
+// Why the node returned
+enum TreeNodeReason : uint8_t {
+    TREE_SEARCHED,
+    TREE_ABORTED,
+    TREE_MATE_DISTANCE,
+    TREE_DRAW,
+    TREE_MAX_PLY,
+    TREE_TT_CUTOFF,
+    TREE_RFP,
+    TREE_RAZORING,
+    TREE_NMP,
+    TREE_NO_MOVE,
+    TREE_STAND_PAT,
+    NB_TREE_NODE_REASON
+};
+
+// Nodes are written when they return, so the children of a node come right before it in the trace
+struct TreeRecord {
+    uint16_t move;      // Move leading to the node
+    int16_t alpha;      // Window when entering the node
+    int16_t beta;
+    int16_t score;
+    uint8_t ply;
+    int8_t depth;
+    uint8_t kind;       // TreeNodeKind
+    uint8_t flags;      // bits 0-3: TreeNodeReason, bit 4: TT hit
+};
+
+static_assert(sizeof(TreeRecord) == 12);
+
+constexpr char TREE_MAGIC[8] = {'B', 'L', 'T', 'T', 'R', 'E', 'E', '1'};
+constexpr uint8_t TREE_TT_HIT_FLAG = 0x10;
+
+// Buffered writer of a search trace, a node is kept if it is entered before the node budget is spent
+class TreeRecorder {
+public:
+    TreeRecorder() = default;
+    TreeRecorder(const TreeRecorder &) = delete;
+    ~TreeRecorder() { close(); }
+    TreeRecorder& operator=(const TreeRecorder &) = delete;
+
+    bool open(const std::string &filename, int maxPly, size_t maxNodes);
+    void close();
+
+    inline bool enter(int ply) {
+        if (ply > maxPly || nbNodes >= maxNodes) return false;
+        nbNodes++;
+        return true;
+    }
+
+    inline void write(const TreeRecord &record) {
+        buffer.push_back(record);
+        if (buffer.size() >= BufferSize) flush();
+    }
+
+    inline size_t size() const { return nbNodes; }
+
+private:
+    static constexpr size_t BufferSize = 65536;
+
+    void flush();
+
+    std::ofstream file;
+    std::vector<TreeRecord> buffer;
+    int maxPly = 0;
+    size_t maxNodes = 0;
+    size_t nbNodes = 0;
+};
+
+// Record of the current node, written when leaving the scope
+class TreeNodeScope {
+public:
+    inline TreeNodeScope(TreeRecorder *recorder_, Move move, int ply, int depth, Score alpha, Score beta, TreeNodeKind kind)
+    : recorder(recorder_ != nullptr && recorder_->enter(ply) ? recorder_ : nullptr) {
+        record = {uint16_t(move), int16_t(alpha), int16_t(beta), 0, uint8_t(ply), int8_t(depth), kind, 0};
+    }
+
+    inline ~TreeNodeScope() {
+        if (recorder != nullptr) recorder->write(record);
+    }
+
+    inline Score result(Score score, TreeNodeReason reason) {
+        record.score = int16_t(score);
+        record.flags = (record.flags & ~0x0F) | reason;
+        return score;
+    }
+
+    inline void setTTHit(bool hit) { if (hit) record.flags |= TREE_TT_HIT_FLAG; }
+
+private:
+    TreeRecorder *recorder;
+    TreeRecord record;
+};
+
+// Summary of a trace: nodes per ply, depth, kind and return reason, then the largest subtrees
+void treestat(const std::string &filename, int nbSubtrees);
+
+} /* namespace Belette */
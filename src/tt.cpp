@@ -1,12 +1,10 @@
 #include <cstring>
 #include <stdexcept>
 #include "tt.h"
+#include "instrument.h"
 
 namespace Belette {
 
-// Global Transposition Table
-TranspositionTable tt;
-
 TranspositionTable::TranspositionTable(size_t defaultSize): buckets(nullptr), nbBuckets(0), age(0) {
     resize(defaultSize);
 }
@@ -56,6 +54,8 @@ size_t TranspositionTable::usage() const {
 }
 
 std::tuple<bool, TTEntry *> TranspositionTable::get(uint64_t hash) {
+    INSTRUMENT_SCOPE(REGION_TT_PROBE);
+
     TTBucket *bucket = &buckets[index(hash)];
 
     for (TTEntry *entry = bucket->begin(); entry < bucket->end(); entry++) {
@@ -79,6 +79,8 @@ std::tuple<bool, TTEntry *> TranspositionTable::get(uint64_t hash) {
 
 // Update TTEntry with fresh informations. Logic is greatly inspired from stockfish
 void TranspositionTable::set(TTEntry *tte, uint64_t hash, int depth, int ply, Bound bound, Move move, Score eval, Score score, bool pv) {
+    INSTRUMENT_SCOPE(REGION_TT_STORE);
+
     assert(depth >= 0);
     assert(tte != nullptr);
     assert(move != MOVE_NULL);
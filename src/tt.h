@@ -72,7 +72,9 @@ public:
     using TTResult = std::tuple<bool, TTEntry *>;
 
     TranspositionTable(size_t defaultSize = TT_DEFAULT_SIZE);
+    TranspositionTable(const TranspositionTable &) = delete;
     ~TranspositionTable();
+    TranspositionTable &operator=(const TranspositionTable &) = delete;
 
     void resize(size_t size);
     void clear();
@@ -85,6 +87,7 @@ public:
 
     size_t usage() const;
     inline size_t size() const { return nbBuckets; }
+    inline size_t memory() const { return nbBuckets * sizeof(TTBucket); }
 
 private:
     struct TTBucket {
@@ -103,7 +106,5 @@ private:
     inline uint64_t index(uint64_t hash) const { return ((unsigned __int128)hash * (unsigned __int128)nbBuckets) >> 64; }
 };
 
-extern TranspositionTable tt;
-
 } /* namespace Belette */
 
@@ -0,0 +1,364 @@
+
+#include <vector>
+#include <thread>
+#include <barrier>
+#include <random>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <iomanip>
+#include "tune.h"
+#include "dataset.h"
+#include "evaluate.h"
+#include "uci.h"
+#include "utils.h"
+
+namespace Belette {
+
+// Tapered parameters: PSQT[KING..PAWN][NB_SQUARE] followed by PIECE_TYPE_VALUE[PAWN..QUEEN]
+constexpr int PSQT_OFFSET = 0;
+constexpr int MATERIAL_OFFSET = PSQT_OFFSET + (NB_PIECE_TYPE - 1) * NB_SQUARE;
+constexpr int NB_TAPERED_PARAMS = MATERIAL_OFFSET + (QUEEN - PAWN + 1);
+
+constexpr inline int psqtIndex(PieceType pt, Square sq) { return PSQT_OFFSET + (pt - PAWN) * NB_SQUARE + sq; }
+constexpr inline int materialIndex(PieceType pt) { return MATERIAL_OFFSET + (pt - PAWN); }
+
+constexpr int MaxEntryPieces = 32; // Positions with more pieces are not legal, they are skipped
+
+// Evaluation is linear in its parameters: eval = sum(coef * param) over the features of the position
+struct TuneFeature {
+    uint16_t index;
+    int8_t coef;
+};
+
+struct TuneEntry {
+    uint32_t begin;     // First feature in TuneData::features
+    uint8_t count;
+    uint8_t phase;
+    int8_t tempo;       // +1 if white to move, -1 otherwise
+    float result;
+};
+
+struct TuneData {
+    std::vector<TuneEntry> entries;
+    std::vector<TuneFeature> features;
+};
+
+struct TuneWeights {
+    double tapered[NB_TAPERED_PARAMS][NB_PHASE];
+    double tempo;
+};
+
+static void initWeights(TuneWeights &w) {
+    for (PieceType pt = PAWN; pt <= KING; pt = PieceType(pt + 1)) {
+        for (Square sq = SQ_A1; sq < NB_SQUARE; ++sq) {
+            w.tapered[psqtIndex(pt, sq)][MG] = PSQT[pt][MG][sq];
+            w.tapered[psqtIndex(pt, sq)][EG] = PSQT[pt][EG][sq];
+        }
+    }
+
+    for (PieceType pt = PAWN; pt <= QUEEN; pt = PieceType(pt + 1)) {
+        w.tapered[materialIndex(pt)][MG] = PieceValue<MG>(pt);
+        w.tapered[materialIndex(pt)][EG] = PieceValue<EG>(pt);
+    }
+
+    w.tempo = Tempo;
+}
+
+static void addEntry(TuneData &data, const Position &pos, float result) {
+    // Sum the coefficients of each parameter, white & black features on the same index cancel out
+    // A PSQT and a material feature per piece at most
+    TuneFeature features[2 * MaxEntryPieces];
+    int count = 0;
+
+    auto add = [&](int index, int coef) {
+        for (int i = 0; i < count; i++) {
+            if (features[i].index == index) {
+                features[i].coef += coef;
+                return;
+            }
+        }
+        features[count++] = TuneFeature{uint16_t(index), int8_t(coef)};
+    };
+
+    Bitboard pieces = pos.getPiecesBB();
+    bitscan_loop(pieces) {
+        Square sq = bitscan(pieces);
+        Piece p = pos.getPieceAt(sq);
+        PieceType pt = pieceType(p);
+        int coef = side(p) == WHITE ? 1 : -1;
+
+        add(psqtIndex(pt, relativeSquare(side(p), sq)), coef);
+        if (pt != KING)
+            add(materialIndex(pt), coef);
+    }
+
+    TuneEntry entry;
+    entry.begin = data.features.size();
+    entry.count = 0;
+    entry.phase = 4 * pos.nbPieceTypes(QUEEN) + 2 * pos.nbPieceTypes(ROOK) + pos.nbPieceTypes(KNIGHT) + pos.nbPieceTypes(BISHOP);
+    entry.tempo = pos.getSideToMove() == WHITE ? 1 : -1;
+    entry.result = result;
+
+    for (int i = 0; i < count; i++) {
+        if (features[i].coef == 0) continue;
+
+        data.features.push_back(features[i]);
+        entry.count++;
+    }
+
+    data.entries.push_back(entry);
+}
+
+// Evaluation from white point of view, same formula as evaluate() without rounding
+static inline double evaluateEntry(const TuneData &data, const TuneEntry &entry, const TuneWeights &w) {
+    double mg = 0, eg = 0;
+
+    for (const TuneFeature *f = data.features.data() + entry.begin, *end = f + entry.count; f != end; f++) {
+        mg += f->coef * w.tapered[f->index][MG];
+        eg += f->coef * w.tapered[f->index][EG];
+    }
+
+    return (mg * entry.phase + eg * (PHASE_TOTAL - entry.phase)) / PHASE_TOTAL + entry.tempo * w.tempo;
+}
+
+static inline double sigmoid(double k, double eval) {
+    return 1.0 / (1.0 + std::pow(10.0, -k * eval / 400.0));
+}
+
+static double computeError(const TuneData &data, const TuneWeights &w, double k, int nbThreads) {
+    std::vector<double> errors(nbThreads, 0.0);
+    std::vector<std::thread> threads;
+    size_t chunk = (data.entries.size() + nbThreads - 1) / nbThreads;
+
+    for (int t = 0; t < nbThreads; t++) {
+        threads.emplace_back([&, t] {
+            size_t end = std::min(data.entries.size(), (t + 1) * chunk);
+            double error = 0;
+
+            for (size_t i = t * chunk; i < end; i++) {
+                const TuneEntry &entry = data.entries[i];
+                double diff = entry.result - sigmoid(k, evaluateEntry(data, entry, w));
+                error += diff * diff;
+            }
+
+            errors[t] = error;
+        });
+    }
+
+    for (auto &th : threads) th.join();
+
+    double total = 0;
+    for (double e : errors) total += e;
+
+    return total / std::max<size_t>(1, data.entries.size());
+}
+
+// Find the sigmoid scaling which best fits the current evaluation (golden section search)
+static double computeOptimalK(const TuneData &data, const TuneWeights &w, int nbThreads) {
+    const double phi = (std::sqrt(5.0) - 1) / 2;
+    double a = 0.0, b = 3.0;
+    double c = b - phi * (b - a), d = a + phi * (b - a);
+    double fc = computeError(data, w, c, nbThreads), fd = computeError(data, w, d, nbThreads);
+
+    while (b - a > 0.0001) {
+        if (fc < fd) {
+            b = d; d = c; fd = fc;
+            c = b - phi * (b - a);
+            fc = computeError(data, w, c, nbThreads);
+        } else {
+            a = c; c = d; fc = fd;
+            d = a + phi * (b - a);
+            fd = computeError(data, w, d, nbThreads);
+        }
+    }
+
+    return (a + b) / 2;
+}
+
+static void printWeights(std::ostream &os, const TuneWeights &w) {
+    static const char *PIECE_NAMES[NB_PIECE_TYPE] = {"", "Pawn", "Knight", "Bishop", "Rook", "Queen", "King"};
+
+    os << "constexpr Score Tempo = " << std::lround(w.tempo) << ";" << std::endl << std::endl;
+
+    for (PieceType pt = PAWN; pt <= QUEEN; pt = PieceType(pt + 1)) {
+        os << "constexpr Score " << PIECE_NAMES[pt] << "ValueMg = " << std::lround(w.tapered[materialIndex(pt)][MG]) << ";" << std::endl;
+        os << "constexpr Score " << PIECE_NAMES[pt] << "ValueEg = " << std::lround(w.tapered[materialIndex(pt)][EG]) << ";" << std::endl;
+        os << std::endl;
+    }
+
+    os << "constexpr Score PSQT[NB_PIECE_TYPE][NB_PHASE][NB_SQUARE] = {" << std::endl;
+    os << "    {}," << std::endl;
+
+    for (PieceType pt = PAWN; pt <= KING; pt = PieceType(pt + 1)) {
+        os << "    // " << PIECE_NAMES[pt] << std::endl;
+        os << "    {" << std::endl;
+
+        for (Phase p : {MG, EG}) {
+            os << "        {" << std::endl;
+
+            for (int r = RANK_1; r <= RANK_8; r++) {
+                os << "           ";
+                for (int f = FILE_A; f <= FILE_H; f++) {
+                    os << std::setw(4) << std::lround(w.tapered[psqtIndex(pt, square(File(f), Rank(r)))][p]) << ",";
+                }
+                os << std::endl;
+            }
+
+            os << "        }" << (p == MG ? "," : "") << std::endl;
+        }
+
+        os << "    }" << (pt != KING ? "," : "") << std::endl;
+    }
+
+    os << "};" << std::endl;
+}
+
+void tune(const std::string &dataset, const TuneOptions &options) {
+    TuneData data;
+    DataEntry dataEntry;
+    DatasetReader reader;
+    Position pos;
+    int nbThreads = std::max(1, options.threads);
+
+    if (!reader.open(dataset)) {
+        console << "Unable to open dataset " << dataset << std::endl;
+        return;
+    }
+
+    TimeMs start = now();
+
+    while (reader.next(dataEntry)) {
+        if (!pos.setFromFEN(dataEntry.fen) || pos.nbPieces() > MaxEntryPieces) continue;
+        addEntry(data, pos, dataEntry.result);
+    }
+
+    size_t nbEntries = data.entries.size();
+    console << "Loaded " << nbEntries << " positions (" << data.features.size() << " features) in " << (now() - start) << "ms" << std::endl;
+
+    if (nbEntries == 0) return;
+
+    TuneWeights weights;
+    initWeights(weights);
+
+    double k = options.k > 0 ? options.k : computeOptimalK(data, weights, nbThreads);
+    console << "K = " << k << ", initial error = " << std::setprecision(8) << computeError(data, weights, k, nbThreads) << std::endl;
+
+    // Adam optimizer state
+    constexpr double Beta1 = 0.9, Beta2 = 0.999, Epsilon = 1e-8;
+    TuneWeights momentum{}, velocity{};
+    int step = 0;
+
+    std::vector<uint32_t> order(nbEntries);
+    for (size_t i = 0; i < nbEntries; i++) order[i] = i;
+    std::mt19937 rng(1234);
+
+    size_t batchSize = std::min<size_t>(std::max(1, options.batchSize), nbEntries);
+    size_t nbBatches = (nbEntries + batchSize - 1) / batchSize;
+    size_t batchStart = 0;
+    int epoch = 0;
+    double epochError = 0;
+
+    std::vector<TuneWeights> gradients(nbThreads);
+    std::vector<double> errors(nbThreads);
+
+    const double sigmoidDerivativeScale = k * std::log(10.0) / 400.0;
+
+    auto updateWeights = [&]() noexcept {
+        size_t batchEnd = std::min(nbEntries, batchStart + batchSize);
+        double scale = 1.0 / (batchEnd - batchStart);
+        step++;
+
+        auto adam = [&](double &w, double &m, double &v, double g) {
+            g *= scale;
+            m = Beta1 * m + (1 - Beta1) * g;
+            v = Beta2 * v + (1 - Beta2) * g * g;
+            double mHat = m / (1 - std::pow(Beta1, step));
+            double vHat = v / (1 - std::pow(Beta2, step));
+            w -= options.learningRate * mHat / (std::sqrt(vHat) + Epsilon);
+        };
+
+        for (int i = 0; i < NB_TAPERED_PARAMS; i++) {
+            for (int p : {MG, EG}) {
+                double g = 0;
+                for (int t = 0; t < nbThreads; t++) g += gradients[t].tapered[i][p];
+                adam(weights.tapered[i][p], momentum.tapered[i][p], velocity.tapered[i][p], g);
+            }
+        }
+
+        double g = 0;
+        for (int t = 0; t < nbThreads; t++) g += gradients[t].tempo;
+        adam(weights.tempo, momentum.tempo, velocity.tempo, g);
+
+        for (int t = 0; t < nbThreads; t++) epochError += errors[t];
+
+        // Next batch
+        batchStart = batchEnd;
+        if (batchStart >= nbEntries) {
+            epoch++;
+            console << "Epoch " << epoch << " error=" << std::setprecision(8) << epochError / nbEntries
+                    << " time=" << (now() - start) << "ms" << std::endl;
+
+            batchStart = 0;
+            epochError = 0;
+            std::shuffle(order.begin(), order.end(), rng);
+        }
+    };
+
+    std::barrier sync(nbThreads, updateWeights);
+    std::vector<std::thread> threads;
+
+    start = now();
+
+    for (int t = 0; t < nbThreads; t++) {
+        threads.emplace_back([&, t] {
+            for (size_t b = 0; b < nbBatches * options.epochs; b++) {
+                TuneWeights &gradient = gradients[t];
+                std::memset(&gradient, 0, sizeof(TuneWeights));
+                double error = 0;
+
+                size_t batchEnd = std::min(nbEntries, batchStart + batchSize);
+                size_t chunk = (batchEnd - batchStart + nbThreads - 1) / nbThreads;
+                size_t begin = batchStart + t * chunk, end = std::min(batchEnd, begin + chunk);
+
+                for (size_t i = begin; i < end; i++) {
+                    const TuneEntry &entry = data.entries[order[i]];
+                    double s = sigmoid(k, evaluateEntry(data, entry, weights));
+                    double diff = entry.result - s;
+                    error += diff * diff;
+
+                    // Derivative of the squared error with respect to the evaluation
+                    double dE = -2.0 * diff * s * (1 - s) * sigmoidDerivativeScale;
+                    double dMg = dE * entry.phase / PHASE_TOTAL;
+                    double dEg = dE * (PHASE_TOTAL - entry.phase) / PHASE_TOTAL;
+
+                    for (const TuneFeature *f = data.features.data() + entry.begin, *end = f + entry.count; f != end; f++) {
+                        gradient.tapered[f->index][MG] += f->coef * dMg;
+                        gradient.tapered[f->index][EG] += f->coef * dEg;
+                    }
+
+                    gradient.tempo += entry.tempo * dE;
+                }
+
+                errors[t] = error;
+                sync.arrive_and_wait();
+            }
+        });
+    }
+
+    for (auto &th : threads) th.join();
+
+    console << "Final error = " << std::setprecision(8) << computeError(data, weights, k, nbThreads) << std::endl << std::endl;
+
+    if (!options.output.empty()) {
+        std::ofstream out(options.output);
+        printWeights(out, weights);
+        console << "Tuned values written to " << options.output << std::endl;
+    } else {
+        std::ostringstream ss;
+        printWeights(ss, weights);
+        console << ss.str();
+    }
+}
+
+} /* namespace Belette */
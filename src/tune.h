@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+
+namespace Belette {
+
+struct TuneOptions {
+    int epochs = 300;
+    int batchSize = 16384;
+    int threads = 1;
+    double learningRate = 1.0;
+    double k = 0.0; // Sigmoid scaling, computed from the dataset when 0
+    std::string output; // evaluate.h tables are printed to the console when empty
+};
+
+// Texel tuning of the material, PSQT & tempo values of evaluate.h
+void tune(const std::string &dataset, const TuneOptions &options);
+
+} /* namespace Belette */
@@ -1,6 +1,7 @@
 #include <cassert>
 #include <algorithm>
 #include <ctime>
+#include <thread>
 #include "uci.h"
 #include "movegen.h"
 #include "test.h"
@@ -8,6 +9,15 @@
 #include "utils.h"
 #include "movepicker.h"
 #include "bench.h"
+#include "tune.h"
+#include "quietize.h"
+#include "book.h"
+#include "pgn.h"
+#include "analyse.h"
+#include "match.h"
+#include "params.h"
+#include "memory.h"
+#include "solver.h"
 
 namespace Belette {
 
@@ -15,6 +25,7 @@ Console console;
 
 Console::~Console() {
     if (file != nullptr) delete file;
+    if (session != nullptr) delete session;
 }
 
 std::istream& Console::getline(std::string& x) {
@@ -23,20 +34,48 @@ std::istream& Console::getline(std::string& x) {
     return std::cin;
 }
 
+void Console::logOnly(const std::string &str) {
+    std::istringstream lines(str);
+    std::string line;
+
+    while (std::getline(lines, line))
+        logToFile(line + '\n', false);
+}
+
 void Console::setLogFile(const std::string &filename) {
     if (file != nullptr) delete file;
     file = new std::ofstream(filename, std::ios::app);
 }
 
+void Console::setSessionFile(const std::string &filename) {
+    if (session != nullptr) delete session;
+    session = filename.empty() ? nullptr : new SessionRecorder(filename);
+}
+
+// Commands of the protocol whose processing time is tracked
+static const std::set<std::string> UciProtocolCommands = {
+    "uci", "isready", "ucinewgame", "setoption", "position", "go", "stop"
+};
+
 Uci::Uci()  {
     console << "Belette " << VERSION << " by Vincent Bab" << std::endl;
     
     options["Debug Log File"] = UciOption("", [&] (const UciOption &opt) { console.setLogFile(opt); });
+    options["Session File"] = UciOption("", [&] (const UciOption &opt) { console.setSessionFile(opt); });
     options["Hash"] = UciOption(16, 1, 1048576, [&] (const UciOption &opt) { 
         engine.setHashSize(int64_t(opt)*1024*1024);
     });
     options["Threads"] = UciOption(1, 1, 1);
 
+    resources = readSystemResources();
+    options["Auto Hash"] = UciOption(false, [&] (const UciOption &opt) {
+        if (opt) options["Hash"] = std::to_string(autoHashSize());
+    });
+    options["Auto Threads"] = UciOption(false, [&] (const UciOption &opt) {
+        if (opt) options["Threads"] = std::to_string(autoThreads());
+    });
+    options["nodestime"] = UciOption(0, 0, 100000); // Nodes per millisecond of a virtual clock, 0 to use the wall clock
+
     commands["uci"] = &Uci::cmdUci;
     commands["isready"] = &Uci::cmdIsReady;
     commands["ucinewgame"] = &Uci::cmdUciNewGame;
@@ -53,6 +92,53 @@ Uci::Uci()  {
     commands["perftmp"] = &Uci::cmdPerftmp;
     commands["test"] = &Uci::cmdTest;
     commands["bench"] = &Uci::cmdBench;
+    commands["scaling"] = &Uci::cmdScaling;
+    commands["tune"] = &Uci::cmdTune;
+    commands["quietize"] = &Uci::cmdQuietize;
+    commands["makebook"] = &Uci::cmdMakebook;
+    commands["analysegame"] = &Uci::cmdAnalysegame;
+    commands["match"] = &Uci::cmdMatch;
+    commands["latency"] = &Uci::cmdLatency;
+    commands["memory"] = &Uci::cmdMemory;
+    commands["tmstats"] = &Uci::cmdTmstats;
+    commands["replay"] = &Uci::cmdReplay;
+    commands["solve"] = &Uci::cmdSolve;
+    commands["treestat"] = &Uci::cmdTreestat;
+
+#ifdef TUNE
+    for (TunableParam &param : tunableParams()) {
+        options[param.name] = UciOption(param.defaultValue, param.min, param.max, [&param] (const UciOption &opt) {
+            param.value = int(int64_t(opt));
+            Engine::init();
+        });
+    }
+
+    commands["params"] = &Uci::cmdParams;
+#endif
+
+#ifdef INSTRUMENT
+    commands["treerecord"] = &Uci::cmdTreerecord;
+#endif
+}
+
+// Room for the search thread data and stack, the allocator and the runtime
+constexpr size_t ReservedPerThread = sizeof(SearchData) + 1024 * 1024;
+constexpr size_t ReservedHeadroom = 32 * 1024 * 1024;
+
+size_t Uci::autoHashSize() const {
+    ProcessMemory mem;
+    readProcessMemory(mem);
+
+    // The resident memory without the current transposition table is what the rest of the process needs
+    size_t reserved = (mem.rss > engine.hashSize() ? mem.rss - engine.hashSize() : mem.rss)
+                    + autoThreads() * ReservedPerThread + ReservedHeadroom;
+
+    return Belette::autoHashSize(resources, reserved);
+}
+
+int Uci::autoThreads() const {
+    // The search is single threaded for now, see the Threads option
+    return std::min(resources.availableCpus(), 1);
 }
 
 Square Uci::parseSquare(std::string str) {
@@ -102,10 +188,14 @@ std::string Uci::formatMove(Move m) {
 }
 
 Move Uci::parseMove(std::string str) const {
+    return parseMove(engine.position(), str);
+}
+
+Move Uci::parseMove(const Position &pos, std::string str) {
     if (str.length() == 5) str[4] = char(tolower(str[4]));
 
-    Move move;
-    enumerateLegalMoves(engine.position(), [&](Move m) {
+    Move move = MOVE_NONE;
+    enumerateLegalMoves(pos, [&](Move m) {
         if (str == formatMove(m)) {
             move = m;
             return false;
@@ -119,10 +209,11 @@ Move Uci::parseMove(std::string str) const {
 
 void Uci::loop(int argc, char* argv[]) {
     if (argc > 1 && std::string(argv[1]) == "bench") {
-        int depth = DEFAULT_BENCH_DEPTH;
-        if (argc > 2) depth = parseInt(std::string(argv[2]));
+        std::string args;
+        for (int i = 2; i < argc; i++) args += std::string(argv[i]) + " ";
 
-        bench(depth);
+        std::istringstream is(args);
+        cmdBench(is);
 
         return;
     }
@@ -135,6 +226,7 @@ void Uci::loop(int argc, char* argv[]) {
 
         if (line.empty()) continue;
 
+        commandTime = nowUs();
         token.clear();
         parser >> std::skipws >> token;
 
@@ -148,6 +240,9 @@ void Uci::loop(int argc, char* argv[]) {
                 exit = true;
             }
 
+            if (UciProtocolCommands.contains(cmd))
+                engine.latency.onCommand(commandTime, nowUs());
+
             break;
         }
 
@@ -174,6 +269,8 @@ bool Uci::cmdUci(std::istringstream &is) {
         console << "option name " << name << " " << option << std::endl;
     }
 
+    console << "info string " << resources.str() << ", auto hash " << autoHashSize() << " MB threads " << autoThreads() << std::endl;
+
     console << "uciok" << std::endl;
 
     return true;
@@ -282,7 +379,8 @@ bool Uci::cmdGo(std::istringstream& is) {
             is >> token;
             params.maxNodes = parseInt(token);
         } else if (token == "mate") {
-            // unsupported
+            is >> token;
+            params.mate = parseInt(token);
         } else if (token == "movetime") {
             is >> token;
             params.maxTime = parseInt(token);
@@ -291,6 +389,9 @@ bool Uci::cmdGo(std::istringstream& is) {
         }
     }
 
+    params.nodesTime = int64_t(options["nodestime"]);
+
+    engine.latency.onGo(commandTime);
     engine.search(params);
     return true;
 }
@@ -365,11 +466,14 @@ bool Uci::cmdPerftmp(std::istringstream& is) {
 }
 
 bool Uci::cmdStop(std::istringstream& is) {
+    engine.latency.onStop(commandTime);
     engine.stop();
     return true;
 }
 
 bool Uci::cmdQuit(std::istringstream& is) {
+    console.logOnly(engine.latency.report());
+    console.logOnly(engine.timeStats.summary());
     return false;
 }
 
@@ -380,14 +484,520 @@ bool Uci::cmdTest(std::istringstream& is) {
 }
 
 bool Uci::cmdBench(std::istringstream& is) {
-    int depth = DEFAULT_BENCH_DEPTH;
-    is >> depth;
+    BenchOptions benchOptions;
+    benchOptions.hashSize = int64_t(options["Hash"]);
+    bool depthSet = false;
+    std::string token;
+
+    while (is >> token) {
+        if (token == "threads") {
+            is >> token;
+            benchOptions.threads = parseInt(token);
+        } else if (token == "hash") {
+            is >> token;
+            benchOptions.hashSize = std::max(1, parseInt(token));
+        } else if (token == "json") {
+            benchOptions.json = true;
+        } else if (token == "perf") {
+            benchOptions.perf = true;
+        } else if (token == "captures") {
+            benchOptions.captures = true;
+        } else if (token == "movepicker") {
+            benchOptions.movePicker = true;
+        } else if (std::all_of(token.begin(), token.end(), ::isdigit)) {
+            benchOptions.depth = parseInt(token);
+            depthSet = true;
+        } else {
+            benchOptions.file = token;
+        }
+    }
+
+    if (benchOptions.movePicker && !depthSet)
+        benchOptions.depth = DEFAULT_MOVEPICKER_BENCH_DEPTH;
 
-    bench(depth);
+    if (benchOptions.captures)
+        benchCaptures(benchOptions);
+    else if (benchOptions.movePicker)
+        benchMovePicker(benchOptions);
+    else
+        bench(benchOptions);
     
     return true;
 }
 
+bool Uci::cmdScaling(std::istringstream& is) {
+    ScalingOptions scalingOptions;
+    scalingOptions.maxInstances = availableCpus();
+    scalingOptions.hashSizes = {size_t(int64_t(options["Hash"]))};
+    std::string token;
+
+    while (is >> token) {
+        if (token == "depth") {
+            is >> token;
+            scalingOptions.depth = parseInt(token);
+        } else if (token == "instances") {
+            is >> token;
+            scalingOptions.maxInstances = std::max(1, parseInt(token));
+        } else if (token == "hash") {
+            // Comma separated list of sizes
+            is >> token;
+            std::istringstream sizes(token);
+            scalingOptions.hashSizes.clear();
+
+            while (std::getline(sizes, token, ','))
+                scalingOptions.hashSizes.push_back(std::max(1, parseInt(token)));
+        } else {
+            scalingOptions.file = token;
+        }
+    }
+
+    scaling(scalingOptions);
+
+    return true;
+}
+
+bool Uci::cmdTune(std::istringstream& is) {
+    std::string dataset, token;
+    TuneOptions options;
+    options.threads = availableCpus();
+
+    if (!(is >> dataset)) {
+        console << "Usage: tune <dataset> [epochs N] [batch N] [threads N] [lr X] [k X] [out FILE]" << std::endl;
+        return true;
+    }
+
+    while (is >> token) {
+        if (token == "epochs") {
+            is >> token;
+            options.epochs = parseInt(token);
+        } else if (token == "batch") {
+            is >> token;
+            options.batchSize = parseInt(token);
+        } else if (token == "threads") {
+            is >> token;
+            options.threads = parseInt(token);
+        } else if (token == "lr") {
+            is >> options.learningRate;
+        } else if (token == "k") {
+            is >> options.k;
+        } else if (token == "out") {
+            is >> options.output;
+        }
+    }
+
+    tune(dataset, options);
+
+    return true;
+}
+
+bool Uci::cmdQuietize(std::istringstream& is) {
+    std::string input, output, token;
+    QuietizeOptions options;
+
+    if (!(is >> input >> output)) {
+        console << "Usage: quietize <input> <output> [threads N] [maxswing CP] [hash MB] [binary]" << std::endl;
+        return true;
+    }
+
+    while (is >> token) {
+        if (token == "threads") {
+            is >> token;
+            options.threads = parseInt(token);
+        } else if (token == "maxswing") {
+            is >> token;
+            options.maxSwing = parseInt(token);
+        } else if (token == "hash") {
+            is >> token;
+            options.hashSize = std::max(1, parseInt(token));
+        } else if (token == "binary") {
+            options.binary = true;
+        }
+    }
+
+    quietize(input, output, options);
+
+    return true;
+}
+
+bool Uci::cmdMakebook(std::istringstream& is) {
+    std::vector<std::string> files;
+    std::string token;
+    MakeBookOptions options;
+    options.threads = availableCpus();
+
+    while (is >> token) {
+        if (token == "maxply") {
+            is >> token;
+            options.maxPly = parseInt(token);
+        } else if (token == "minweight") {
+            is >> token;
+            options.minWeight = parseInt(token);
+        } else if (token == "threads") {
+            is >> token;
+            options.threads = parseInt(token);
+        } else {
+            files.push_back(token);
+        }
+    }
+
+    if (files.size() < 2) {
+        console << "Usage: makebook <pgn...> <out.bin> [maxply N] [minweight W] [threads N]" << std::endl;
+        return true;
+    }
+
+    std::string output = files.back();
+    files.pop_back();
+
+    makebook(files, output, options);
+
+    return true;
+}
+
+bool Uci::cmdAnalysegame(std::istringstream& is) {
+    std::string source, token;
+    std::vector<Move> moves;
+    AnalyseOptions analyseOptions;
+    analyseOptions.hashSize = int64_t(options["Hash"]);
+
+    if (!(is >> source)) {
+        console << "Usage: analysegame <pgn file|moves m1 m2 ...> [depth N] [movetime MS] [blunder CP] [independent]" << std::endl;
+        return true;
+    }
+
+    // Moves are played from the current position, a PGN game from its own start position
+    Position start = engine.position();
+    Position pos = start;
+
+    if (source != "moves") {
+        PgnReader reader;
+        PgnGame game;
+        std::string text;
+        size_t offset = 0;
+
+        if (!reader.open(source) || !reader.nextChunk(text, 1) || !parsePgnGame(text, offset, game)) {
+            console << "Unable to read a game from " << source << std::endl;
+            return true;
+        }
+
+        if (!start.setFromFEN(game.fen.empty() ? STARTPOS_FEN : game.fen)) {
+            console << "Invalid FEN position" << std::endl;
+            return true;
+        }
+
+        pos = start;
+        for (const std::string &san : game.moves) {
+            Move m = parseSan(pos, san);
+            if (m == MOVE_NONE) {
+                console << "Illegal move " << san << ", the game is analysed up to there" << std::endl;
+                break;
+            }
+
+            pos.doMove(m);
+            moves.push_back(m);
+        }
+    }
+
+    while (is >> token) {
+        if (token == "depth") {
+            is >> token;
+            analyseOptions.depth = parseInt(token);
+        } else if (token == "movetime") {
+            is >> token;
+            analyseOptions.moveTime = parseInt(token);
+        } else if (token == "blunder") {
+            is >> token;
+            analyseOptions.blunder = parseInt(token);
+        } else if (token == "independent") {
+            analyseOptions.independent = true;
+        } else if (source == "moves") {
+            Move m = parseMove(pos, token);
+            if (m == MOVE_NONE) {
+                console << "Illegal move " << token << std::endl;
+                return true;
+            }
+
+            pos.doMove(m);
+            moves.push_back(m);
+        }
+    }
+
+    if (analyseOptions.depth <= 0 && analyseOptions.moveTime <= 0)
+        analyseOptions.depth = 12;
+
+    analyseGame(start, moves, analyseOptions);
+
+    return true;
+}
+
+bool Uci::cmdMatch(std::istringstream& is) {
+    std::string engineA, engineB, token;
+    MatchOptions options;
+    options.concurrency = availableCpus();
+
+    if (!(is >> engineA >> engineB)) {
+        console << "Usage: match <engineA|self> <engineB|self> [games N] [concurrency N] [tc S+I | nodes N | movetime MS] [nodestime N] [openings FILE]"
+                << " [optionA NAME=VALUE] [optionB NAME=VALUE] [sprt ELO0 ELO1] [resign CP MOVES] [draw CP MOVES]" << std::endl;
+        return true;
+    }
+
+    while (is >> token) {
+        if (token == "games") {
+            is >> token;
+            options.games = parseInt(token);
+        } else if (token == "concurrency") {
+            is >> token;
+            options.concurrency = parseInt(token);
+        } else if (token == "tc") {
+            is >> token;
+            size_t plus = token.find('+');
+            options.time = TimeMs(std::atof(token.substr(0, plus).c_str()) * 1000);
+            options.increment = plus == std::string::npos ? 0 : TimeMs(std::atof(token.substr(plus + 1).c_str()) * 1000);
+        } else if (token == "nodes") {
+            is >> token;
+            options.nodes = parseInt(token);
+        } else if (token == "movetime") {
+            is >> token;
+            options.moveTime = parseInt(token);
+        } else if (token == "nodestime") {
+            is >> token;
+            options.nodesTime = parseInt(token);
+        } else if (token == "openings") {
+            is >> options.openings;
+        } else if (token == "optionA" || token == "optionB") {
+            std::string option;
+            is >> option;
+            options.engineOptions[token == "optionB"].push_back(option);
+        } else if (token == "sprt") {
+            options.sprt = true;
+            is >> options.elo0 >> options.elo1;
+        } else if (token == "resign") {
+            is >> options.resignScore >> options.resignMoves;
+        } else if (token == "draw") {
+            is >> options.drawScore >> options.drawMoves;
+        }
+    }
+
+    match(engineA, engineB, options);
+
+    return true;
+}
+
+bool Uci::cmdLatency(std::istringstream& is) {
+    std::string token;
+
+    if (is >> token && token == "clear") {
+        engine.latency.clear();
+        return true;
+    }
+
+    console << engine.latency.report();
+
+    return true;
+}
+
+bool Uci::cmdMemory(std::istringstream& is) {
+    std::string token;
+
+    if (is >> token) {
+        std::string value;
+        if (token != "stack" || !(is >> value) || (value != "on" && value != "off")) {
+            console << "Usage: memory [stack on|off]" << std::endl;
+            return true;
+        }
+
+        engine.setTrackSearchStack(value == "on");
+        return true;
+    }
+
+    MemoryReport report;
+    addStaticTables(report);
+    engine.memoryUsage(report);
+    report.add("latency histograms", sizeof(LatencyTracker));
+    console << report.str();
+
+    ProcessMemory mem;
+    if (readProcessMemory(mem)) {
+        console << "main thread stack " << mem.mainStack / 1024 << " KiB (VmStk)" << std::endl;
+    }
+
+    const StackWatermark &stack = engine.searchStack();
+    if (stack.measured()) {
+        console << "search thread stack high-water " << stack.used() / 1024 << " KiB of " << stack.stackSize() / 1024
+                << " KiB (" << stack.paintedSize() / 1024 << " KiB painted)" << std::endl;
+    } else {
+        console << "search thread stack not measured, use \"memory stack on\" before searching" << std::endl;
+    }
+
+    if (mem.rss > 0) {
+        console << "resident " << mem.rss / 1024 << " KiB, peak " << mem.peakRss / 1024 << " KiB, data " << mem.data / 1024 << " KiB" << std::endl;
+    }
+
+    return true;
+}
+
+bool Uci::cmdTmstats(std::istringstream& is) {
+    std::string token;
+
+    if (is >> token && token == "clear") {
+        engine.timeStats.clear();
+        return true;
+    }
+
+    console << engine.timeStats.summary();
+
+    return true;
+}
+
+bool Uci::cmdReplay(std::istringstream& is) {
+    ReplayOptions replayOptions;
+    std::string filename, token;
+
+    if (!(is >> filename)) {
+        console << "Usage: replay <file> [speed X] [engine PATH]" << std::endl;
+        return true;
+    }
+
+    while (is >> token) {
+        if (token == "speed") {
+            is >> token;
+            replayOptions.speed = std::max(0.01, std::atof(token.c_str()));
+        } else if (token == "engine") {
+            is >> replayOptions.engine;
+        }
+    }
+
+    replay(filename, replayOptions);
+
+    return true;
+}
+
+bool Uci::cmdSolve(std::istringstream& is) {
+    SolveOptions solveOptions;
+    solveOptions.hashSize = int64_t(options["Hash"]);
+    std::string token, fen;
+
+    if (!(is >> token) || token != "mate") {
+        console << "Usage: solve mate [<fen>] [nodes N] [threads N] [hash MB]" << std::endl;
+        return true;
+    }
+
+    // The FEN fields go up to the first option, the current position without them
+    while (is >> token) {
+        if (token == "nodes") {
+            is >> token;
+            solveOptions.maxNodes = parseInt(token);
+        } else if (token == "threads") {
+            is >> token;
+            solveOptions.threads = std::max(1, parseInt(token));
+        } else if (token == "hash") {
+            is >> token;
+            solveOptions.hashSize = std::max(1, parseInt(token));
+        } else {
+            fen += token + " ";
+        }
+    }
+
+    Position pos = engine.position();
+    if (!fen.empty() && !pos.setFromFEN(fen)) {
+        console << "Invalid FEN position" << std::endl;
+        return true;
+    }
+
+    Side them = ~pos.getSideToMove();
+    if (pos.getAttackers(pos.getKingSquare(them), pos.getPiecesBB()) & pos.getPiecesBB(pos.getSideToMove())) {
+        console << "Invalid position, the side not to move is in check" << std::endl;
+        return true;
+    }
+
+    SolveResult result = solveMate(pos, solveOptions);
+    TimeMs elapsed = std::max<TimeMs>(result.elapsed, 1);
+
+    if (result.status == SOLVE_PROVEN) {
+        int plies = result.distance;
+
+        console << "info depth " << plies << " score " << formatScore(SCORE_MATE - plies) << " nodes " << result.nbNodes
+                << " nps " << result.nbNodes * 1000 / elapsed << " time " << elapsed << " hashfull " << result.hashfull << " pv";
+        for (Move move : result.pv) console << " " << formatMove(move);
+        console << std::endl;
+
+        console << "Mate in " << (plies + 1) / 2 << " proven, " << result.nbNodes << " nodes" << std::endl;
+    } else if (result.status == SOLVE_DISPROVEN) {
+        console << "No forced mate, " << result.nbNodes << " nodes" << std::endl;
+    } else if (result.status == SOLVE_UNRESOLVED) {
+        console << "Unknown after " << result.nbNodes << " nodes, no mate found but the disproof relies on repetitions" << std::endl;
+    } else {
+        console << "Unknown after " << result.nbNodes << " nodes" << std::endl;
+    }
+
+    return true;
+}
+
+bool Uci::cmdTreestat(std::istringstream& is) {
+    std::string filename, token;
+    int nbSubtrees = 10;
+
+    if (!(is >> filename)) {
+        console << "Usage: treestat <file> [top N]" << std::endl;
+        return true;
+    }
+
+    while (is >> token) {
+        if (token == "top") {
+            is >> token;
+            nbSubtrees = parseInt(token);
+        }
+    }
+
+    treestat(filename, nbSubtrees);
+
+    return true;
+}
+
+#ifdef INSTRUMENT
+// Arm the tree recorder for the next search
+bool Uci::cmdTreerecord(std::istringstream& is) {
+    std::string filename, token;
+    int maxPly = MAX_PLY;
+    size_t maxNodes = 10000000;
+
+    if (!(is >> filename)) {
+        console << "Usage: treerecord <file> [maxply N] [nodes N]" << std::endl;
+        return true;
+    }
+
+    while (is >> token) {
+        if (token == "maxply") {
+            is >> token;
+            maxPly = parseInt(token);
+        } else if (token == "nodes") {
+            is >> token;
+            maxNodes = parseInt64(token);
+        }
+    }
+
+    if (!engine.recordTree(filename, maxPly, maxNodes))
+        console << "Unable to record the tree to " << filename << std::endl;
+
+    return true;
+}
+#endif
+
+#ifdef TUNE
+// SPSA input, one "name, int, value, min, max, step, learning rate" line per parameter
+bool Uci::cmdParams(std::istringstream& is) {
+    for (const TunableParam &param : tunableParams()) {
+        console << param.name << ", int, " << param.value << ", " << param.min << ", " << param.max
+                << ", " << param.step << ", 0.002" << std::endl;
+    }
+
+    return true;
+}
+#endif
+
+void UciEngine::onSearchStart() {
+    latency.onSearchStart();
+}
+
 void UciEngine::onSearchProgress(const SearchEvent &event) {
     console << "info"
         << " depth " << event.depth 
@@ -404,13 +1014,31 @@ void UciEngine::onSearchProgress(const SearchEvent &event) {
         console << " pv " << event.pv;
     
     console << std::endl;
+    latency.onInfo();
 }
 
 void UciEngine::onSearchFinish(const SearchEvent &event) {
     Move bestMove = MOVE_NONE;
     if (!event.pv.empty()) bestMove = event.pv.front();
 
+    const SearchData &data = searchData();
+    if (data.useTournamentTime()) {
+        Side stm = data.position.getSideToMove();
+        TimeRecord record { data.limits.timeLeft[stm], data.limits.increment[stm], data.limits.movesToGo,
+                            data.allocatedTime, data.getElapsed(), event.completedDepth, event.stopReason,
+                            data.cpuTime, data.contention };
+
+        console << "info string tm " << record.str() << std::endl;
+        if (timeStats.record(record) == 1) console.logOnly(std::string("tm,") + TimeRecord::csvHeader());
+        console.logOnly(std::string("tm,") + record.csv());
+    }
+
+    if (data.limits.mate > 0 && event.stopReason != STOP_MATE_PROVEN)
+        console << "info string no mate in " << data.limits.mate << " found" << std::endl;
+
+    TimeUs start = nowUs();
     console << "bestmove " << Uci::formatMove(bestMove) << std::endl;
+    latency.onBestMove(start, nowUs());
 }
 
 
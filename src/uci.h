@@ -10,6 +10,10 @@
 #include <filesystem>
 #include "uci_option.h"
 #include "engine.h"
+#include "latency.h"
+#include "timestats.h"
+#include "session.h"
+#include "resources.h"
 
 #define VERSION "3.1.0-DEV"
 
@@ -26,15 +30,19 @@ public:
     Console &operator=(const Console &) = delete;
 
     void setLogFile(const std::string &filename);
+    void setSessionFile(const std::string &filename); // Timestamped record of the session, for replay
+    void logOnly(const std::string &str); // Not written to stdout
     std::istream& getline(std::string& str);
 
     template <class T> friend Console& operator<<(Console& console, const T& x);
     friend Console& operator<<(Console& console, Manipulator manip);
 private:
     template <class T> Console &log(const T& x, bool isInput = false);
+    template <class T> void logToFile(const T& x, bool isInput);
 
     std::stringstream buffer;
     std::ofstream *file;
+    SessionRecorder *session = nullptr;
 };
 
 extern Console console;
@@ -53,6 +61,13 @@ inline Console& operator<<(Console& console, const T& x) {
 }
 
 template <class T> Console& Console::log(const T& x, bool isInput) {
+    if (session != nullptr) session->append(x, isInput);
+    logToFile(x, isInput);
+
+    return *this;
+}
+
+template <class T> void Console::logToFile(const T& x, bool isInput) {
     if (file != nullptr) {
         if (buffer.rdbuf()->in_avail() == 0) {
             auto now = time(nullptr);
@@ -67,14 +82,17 @@ template <class T> Console& Console::log(const T& x, bool isInput) {
         }
         
     }
-
-    return *this;
 }
 
 
 
 class UciEngine : public Engine {
+public:
+    LatencyTracker latency;
+    TimeStats timeStats;
+
 protected:
+    virtual void onSearchStart();
     virtual void onSearchProgress(const SearchEvent &event);
     virtual void onSearchFinish(const SearchEvent &event);
 };
@@ -86,6 +104,7 @@ public:
     void loop(int argc, char* argv[]);
 
     Move parseMove(std::string str) const;
+    static Move parseMove(const Position &pos, std::string str);
 
     static Square parseSquare(std::string str);
     static std::string formatSquare(Square sq);
@@ -105,6 +124,12 @@ private:
     std::map<std::string, UciOption, CaseInsensitiveComparator> options;
     std::map<std::string, UciCommandHandler> commands;
     UciEngine engine;
+    TimeUs commandTime = 0; // Receipt of the command being processed
+    SystemResources resources;
+
+    // Values picked by the Auto Hash and Auto Threads options
+    size_t autoHashSize() const;
+    int autoThreads() const;
 
     bool cmdUci(std::istringstream& is);
     bool cmdIsReady(std::istringstream& is);
@@ -121,6 +146,27 @@ private:
     bool cmdPerftmp(std::istringstream& is);
     bool cmdTest(std::istringstream& is);
     bool cmdBench(std::istringstream& is);
+    bool cmdScaling(std::istringstream& is);
+    bool cmdTune(std::istringstream& is);
+    bool cmdQuietize(std::istringstream& is);
+    bool cmdMakebook(std::istringstream& is);
+    bool cmdAnalysegame(std::istringstream& is);
+    bool cmdMatch(std::istringstream& is);
+    bool cmdLatency(std::istringstream& is);
+    bool cmdMemory(std::istringstream& is);
+    bool cmdTmstats(std::istringstream& is);
+    bool cmdReplay(std::istringstream& is);
+    bool cmdSolve(std::istringstream& is);
+
+    bool cmdTreestat(std::istringstream& is);
+
+#ifdef TUNE
+    bool cmdParams(std::istringstream& is);
+#endif
+
+#ifdef INSTRUMENT
+    bool cmdTreerecord(std::istringstream& is);
+#endif
 };
 
 } /* namespace Belette */
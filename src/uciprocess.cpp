@@ -0,0 +1,169 @@
+#include <thread>
+#include <climits>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "uciprocess.h"
+
+namespace Belette {
+
+bool UciProcess::spawn(const std::string &path) {
+    int toChild[2], fromChild[2];
+
+    if (pipe2(toChild, O_CLOEXEC)) return false;
+    if (pipe2(fromChild, O_CLOEXEC)) {
+        close(toChild[0]); close(toChild[1]);
+        return false;
+    }
+
+    pid = fork();
+
+    if (pid == 0) {
+        dup2(toChild[0], STDIN_FILENO);
+        dup2(fromChild[1], STDOUT_FILENO);
+        execl(path.c_str(), path.c_str(), (char *)nullptr);
+        _exit(127);
+    }
+
+    close(toChild[0]);
+    close(fromChild[1]);
+    in = toChild[1];
+    out = fromChild[0];
+    closed = false;
+    buffer.clear();
+
+    if (pid < 0) {
+        stop();
+        return false;
+    }
+
+    return true;
+}
+
+bool UciProcess::start(const std::string &path, const std::vector<std::string> &options) {
+    if (!spawn(path)) return false;
+
+    std::string line;
+    send("uci");
+
+    while (readLine(line, StartupTimeout) && line != "uciok") {
+        if (line.starts_with("id name ")) name = line.substr(8);
+    }
+
+    if (line != "uciok") {
+        stop();
+        return false;
+    }
+
+    for (const std::string &option : options) {
+        size_t eq = option.find('=');
+        send("setoption name " + option.substr(0, eq) + (eq == std::string::npos ? "" : " value " + option.substr(eq + 1)));
+    }
+
+    send("isready");
+    if (!waitFor("readyok", StartupTimeout)) {
+        stop();
+        return false;
+    }
+
+    return true;
+}
+
+void UciProcess::stop() {
+    if (pid > 0) {
+        send("quit");
+
+        // Give it some time to exit by itself
+        int status;
+        TimeMs deadline = now() + 1000;
+        while (waitpid(pid, &status, WNOHANG) == 0) {
+            if (now() > deadline) {
+                kill(pid, SIGKILL);
+                waitpid(pid, &status, 0);
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+
+    if (in >= 0) close(in);
+    if (out >= 0) close(out);
+    pid = -1;
+    in = out = -1;
+}
+
+// The engine closed its output: it is collected right away when it already exited, by stop() otherwise
+void UciProcess::reap() {
+    int status;
+
+    closed = true;
+    if (pid > 0 && waitpid(pid, &status, WNOHANG) == pid) pid = -1;
+}
+
+bool UciProcess::send(const std::string &line) {
+    std::string str = line + '\n';
+    const char *data = str.data();
+    size_t left = str.size();
+
+    while (left > 0) {
+        ssize_t n = write(in, data, left);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        left -= n;
+    }
+
+    return true;
+}
+
+bool UciProcess::readLine(std::string &line, TimeMs timeout) {
+    TimeMs deadline = now() + timeout;
+
+    while (true) {
+        size_t eol = buffer.find('\n');
+        if (eol != std::string::npos) {
+            line = buffer.substr(0, eol);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            buffer.erase(0, eol + 1);
+            return true;
+        }
+
+        TimeMs remaining = deadline - now();
+        if (remaining <= 0) return false;
+
+        pollfd pfd = {out, POLLIN, 0};
+        int r = poll(&pfd, 1, int(std::min<TimeMs>(remaining, INT_MAX)));
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+
+        char data[4096];
+        ssize_t n = read(out, data, sizeof(data));
+        if (n == 0) reap();
+        if (n <= 0) return false;
+
+        buffer.append(data, n);
+    }
+}
+
+bool UciProcess::waitFor(const std::string &token, TimeMs timeout) {
+    TimeMs deadline = now() + timeout;
+    std::string line;
+
+    while (readLine(line, deadline - now())) {
+        if (line.starts_with(token)) return true;
+    }
+
+    return false;
+}
+
+std::string enginePath(const std::string &path) {
+    if (path != "self") return path;
+
+    char buffer[4096];
+    ssize_t n = readlink("/proc/self/exe", buffer, sizeof(buffer) - 1);
+    return n > 0 ? std::string(buffer, n) : path;
+}
+
+} /* namespace Belette */
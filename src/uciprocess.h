@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include "utils.h"
+
+namespace Belette {
+
+constexpr TimeMs StartupTimeout = 10000;
+
+// UCI engine running in a child process, talking through pipes
+class UciProcess {
+public:
+    UciProcess() = default;
+    UciProcess(const UciProcess &) = delete;
+    ~UciProcess() { stop(); }
+    UciProcess& operator=(const UciProcess &) = delete;
+
+    // Launch the engine and go through the uci/isready handshake, options are "Name=Value"
+    bool start(const std::string &path, const std::vector<std::string> &options);
+    // Only launch the engine, nothing is sent
+    bool spawn(const std::string &path);
+    void stop();
+    // False as soon as the engine closed its output, when it crashed or quit
+    inline bool isRunning() const { return pid > 0 && !closed; }
+
+    bool send(const std::string &line);
+    bool readLine(std::string &line, TimeMs timeout);
+    bool waitFor(const std::string &token, TimeMs timeout);
+
+    std::string name;
+
+private:
+    pid_t pid = -1;
+    int in = -1, out = -1;
+    bool closed = false; // End of the output reached
+    std::string buffer;
+
+    void reap();
+};
+
+// Path of an engine, "self" is this binary
+std::string enginePath(const std::string &path);
+
+} /* namespace Belette */
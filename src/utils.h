@@ -1,6 +1,7 @@
 #pragma once
 
 #include <chrono>
+#include <ctime>
 #include <string>
 
 namespace Belette {
@@ -11,6 +12,25 @@ inline TimeMs now() {
     return std::chrono::duration_cast<std::chrono::milliseconds> (std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
+using TimeUs = std::chrono::microseconds::rep;
+
+inline TimeUs nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+using TimeNs = std::chrono::nanoseconds::rep;
+
+inline TimeNs nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// CPU time of the calling thread, the time taken by the other processes is not counted
+inline TimeMs threadCpuTime() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return TimeMs(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
 inline int parseInt(const std::string &str) {
     try {
         return std::stoi(str);